@@ -6,16 +6,32 @@
 #include <functional>
 #include <vector>
 #include <map>
+#include <cstdint>
+#include "data_generator.h"
 
 // 性能结果结构
 struct PerformanceResult {
     std::string algorithmName;
     std::string dataType;
+    std::string distribution = "uniform";   // 输入分布（DataGenerator::distributionName）
     int64_t dataSize;
     double timeSeconds;
     size_t memoryUsageBytes;
     size_t peakMemoryBytes;
     bool isSorted;
+    double loadSeconds = 0;           // 其中读入/映射输入的耗时（内存排序的文件接口）
+    uint64_t writeBytes = 0;          // 经 FileUtils 输出文件写出的字节数
+    double writeSeconds = 0;          // 输出文件从打开到关闭的耗时
+
+    // 写出吞吐（MB/s），没有写出统计时为 0
+    double writeMBps() const { return writeSeconds > 0 ? writeBytes / 1024.0 / 1024.0 / writeSeconds : 0; }
+
+    // 外排序阶段统计（其他算法为 0）
+    int runCount = 0;
+    double runPhaseSeconds = 0;
+    double mergePhaseSeconds = 0;
+    uint64_t spillBytes = 0;          // 临时顺串写入字节数
+    double compressionRatio = 0;      // 顺串压缩比（原始/写入）
 
     PerformanceResult() = default;
     PerformanceResult(const std::string& name, const std::string& type,
@@ -52,6 +68,15 @@ public:
     // 运行所有测试
     static std::vector<PerformanceResult> runAllTests();
 
+    // 按输入分布扫描（整数/浮点数）：各分布的输入文件不存在时按当前种子生成
+    static std::vector<PerformanceResult> runDistributionTests(
+        int64_t size,
+        const std::vector<Distribution>& distributions = DataGenerator::allDistributions());
+
+    // 测试输入文件名：均匀随机数据为 data/test_<类型>_<规模>.dat，其他分布在类型前加分布名
+    static std::string inputFilename(const std::string& dataType, int64_t size,
+                                     Distribution distribution = Distribution::UNIFORM);
+
     // 生成测试报告
     static void generateReport(const std::vector<PerformanceResult>& results);
 
@@ -66,10 +91,14 @@ public:
     static std::string formatTime(double seconds);
 
 private:
+    // 按算法名后缀配置外排序变体（如 ExternalSort-Codec）
+    static void applyExternalSortVariant(const std::string& algorithm);
+
     // 运行单个测试用例 - 这里修改了返回类型
     static PerformanceResult runTest(const std::string& algorithm,
                                     const std::string& dataType,
-                                    int64_t size);
+                                    int64_t size,
+                                    Distribution distribution = Distribution::UNIFORM);
 };
 
 #endif // BENCHMARK_H
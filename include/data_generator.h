@@ -6,6 +6,8 @@
 #include <cstdint>
 #include <functional>
 #include <random>
+#include "file_utils.h"
+#include "string_column.h"
 
 // 数据类型枚举
 enum class DataType {
@@ -23,6 +25,160 @@ enum class DataSize {
     SIZE_1G   = 1000000000
 };
 
+// 输入分布：均匀随机之外的结构化与病态形状，用于检验算法在各种输入上的表现
+enum class Distribution {
+    UNIFORM,          // 均匀随机
+    SORTED,           // 升序
+    REVERSE_SORTED,   // 降序
+    NEARLY_SORTED,    // 升序后随机交换一定比例的元素
+    ORGAN_PIPE,       // 先升后降
+    SAWTOOTH,         // 若干段重复的升序锯齿
+    FEW_UNIQUE,       // 只有少数几个不同取值
+    ALL_EQUAL,        // 全部相等
+    ZIPF,             // Zipf 偏斜（少数取值占大多数）
+    SORTED_RUNS,      // 若干有序顺串首尾相接（取值区间互相交错）
+    MEDIAN3_KILLER    // 针对首/中/尾三数取中快速排序的最坏输入（Musser）
+};
+
+// 结构化分布的参数
+struct DistributionOptions {
+    double swapPercent = 1.0;       // NEARLY_SORTED：参与交换的元素比例（%），位置在全局随机两两配对
+    int64_t runCount = 16;          // SAWTOOTH / SORTED_RUNS：锯齿或顺串的个数
+    int64_t uniqueValues = 16;      // FEW_UNIQUE：不同取值的个数
+    double zipfExponent = 1.0;      // ZIPF：偏斜指数 s
+    int64_t zipfRange = 1000000;    // ZIPF：取值范围 [0, zipfRange)
+};
+
+// 计数器式随机数发生器（SplitMix64 的混合函数）：第 n 个输出只由种子、流号、
+// 块号和 n 决定，各块可以在任意线程上独立生成，结果与线程数无关
+class CounterRng {
+public:
+    using result_type = uint64_t;
+
+    CounterRng(uint64_t seed, uint64_t stream, uint64_t block)
+        : key(mix(mix(seed ^ (stream * GAMMA)) + block * GAMMA)), counter(0) {}
+
+    uint64_t operator()() { return mix(key + (++counter) * GAMMA); }
+    static constexpr uint64_t min() { return 0; }
+    static constexpr uint64_t max() { return ~0ULL; }
+
+    // [0, bound) 内的整数（乘法取高位）
+    uint64_t below(uint64_t bound) {
+#ifdef __SIZEOF_INT128__
+        return static_cast<uint64_t>((static_cast<unsigned __int128>((*this)()) * bound) >> 64);
+#else
+        return (*this)() % bound;
+#endif
+    }
+
+    // [0, 1) 内的浮点数（53 位精度）
+    double unit() { return ((*this)() >> 11) * (1.0 / 9007199254740992.0); }
+
+    static uint64_t mix(uint64_t x) {
+        x ^= x >> 30;
+        x *= 0xbf58476d1ce4e5b9ULL;
+        x ^= x >> 27;
+        x *= 0x94d049bb133111ebULL;
+        x ^= x >> 31;
+        return x;
+    }
+
+private:
+    static const uint64_t GAMMA = 0x9e3779b97f4a7c15ULL;
+
+    uint64_t key;
+    uint64_t counter;
+};
+
+// 带密钥的 Feistel 置换：[0, domain) 上的双射，O(1) 内存、按下标独立求值。
+// 在不小于 domain 的最小 2^bits 上做（两半位数可相差 1 的）Feistel，结果越界时
+// 继续迭代（cycle walking），因 2^bits < 2·domain，平均迭代不到 2 次
+class FeistelPermutation {
+public:
+    FeistelPermutation(uint64_t domain, uint64_t key) : domain(domain), bits(2) {
+        while (bits < 63 && (1ULL << bits) < domain) bits++;
+        for (int round = 0; round < ROUNDS; round++) {
+            offsets[round] = CounterRng::mix(key + 2 * round);
+            multipliers[round] = CounterRng::mix(key + 2 * round + 1) | 1;
+        }
+    }
+
+    // 下标 index (< domain) 在置换中的像
+    uint64_t operator()(uint64_t index) const {
+        uint64_t value = index;
+        do {
+            value = encrypt(value);
+        } while (value >= domain);
+        return value;
+    }
+
+    // 逆置换：value (< domain) 的原像
+    uint64_t inverse(uint64_t value) const {
+        do {
+            value = decrypt(value);
+        } while (value >= domain);
+        return value;
+    }
+
+    // 下标 first 起连续 n 个下标的像。整体加密一遍后，把越界元素的位置收集起来
+    // 成批继续迭代，避免逐个 cycle walking 的分支预测失败
+    void apply(uint64_t first, uint64_t* out, size_t n) const {
+        std::vector<size_t> pending(n);
+        size_t count = 0;
+        for (size_t j = 0; j < n; j++) {
+            out[j] = encrypt(first + j);
+            pending[count] = j;
+            count += out[j] >= domain;
+        }
+        while (count > 0) {
+            size_t remaining = 0;
+            for (size_t k = 0; k < count; k++) {
+                size_t j = pending[k];
+                out[j] = encrypt(out[j]);
+                pending[remaining] = j;
+                remaining += out[j] >= domain;
+            }
+            count = remaining;
+        }
+    }
+
+private:
+    static const int ROUNDS = 4;
+
+    // 每轮：高半部分异或低半部分的轮函数值，再交换两半（两半位数交替）
+    uint64_t encrypt(uint64_t value) const {
+        int lowBits = bits / 2;
+        for (int round = 0; round < ROUNDS; round++) {
+            int highBits = bits - lowBits;
+            uint64_t low = value & ((1ULL << lowBits) - 1);
+            uint64_t high = value >> lowBits;
+            // 轮函数：带密钥的乘法取高位，每轮只有一次乘法
+            high ^= ((low + offsets[round]) * multipliers[round]) >> (64 - highBits);
+            value = (low << highBits) | high;
+            lowBits = highBits;
+        }
+        return value;
+    }
+
+    // encrypt 的各轮倒序执行
+    uint64_t decrypt(uint64_t value) const {
+        for (int round = ROUNDS - 1; round >= 0; round--) {
+            int lowBits = round % 2 == 0 ? bits / 2 : bits - bits / 2;
+            int highBits = bits - lowBits;
+            uint64_t high = value & ((1ULL << highBits) - 1);
+            uint64_t low = value >> highBits;
+            high ^= ((low + offsets[round]) * multipliers[round]) >> (64 - highBits);
+            value = (high << lowBits) | low;
+        }
+        return value;
+    }
+
+    uint64_t domain;
+    int bits;
+    uint64_t offsets[ROUNDS];
+    uint64_t multipliers[ROUNDS];
+};
+
 // 数据生成器类
 class DataGenerator {
 public:
@@ -41,15 +197,61 @@ public:
                                    int64_t size,
                                    bool allowDuplicates = false);
 
+    // 按指定分布生成整数或浮点数数据（结构化分布的取值为整数，浮点数文件按同样的形状取值）
+    static void generateDistributionData(const std::string& filename,
+                                         int64_t size,
+                                         Distribution distribution,
+                                         DataType type = DataType::INTEGER);
+
+    // 结构化分布的参数
+    static void setDistributionOptions(const DistributionOptions& options);
+    static const DistributionOptions& getDistributionOptions() { return distributionOptions; }
+
+    // 分布名（如 "nearly-sorted"）与名字的解析；allDistributions 按枚举顺序列出全部分布
+    static const char* distributionName(Distribution distribution);
+    static bool parseDistribution(const std::string& name, Distribution& distribution);
+    static std::vector<Distribution> allDistributions();
+
     // 从二进制文件读取整数数据
-    static std::vector<int64_t> readIntegerData(const std::string& filename);
+    static DataBuffer<int64_t> readIntegerData(const std::string& filename);
 
     // 从二进制文件读取浮点数数据
-    static std::vector<double> readDoubleData(const std::string& filename);
+    static DataBuffer<double> readDoubleData(const std::string& filename);
 
-    // 从文本文件读取字符串数据
+    // 读取字符串数据（文本或二进制字符串格式）
     static std::vector<std::string> readStringData(const std::string& filename);
 
+    // 读取字符串列（文本或二进制字符串格式；连续 arena，不逐个分配字符串）
+    static StringColumn readStringColumn(const std::string& filename);
+
+    // 写出整数/浮点数数据；withHeader 时带数据文件头
+    static void writeIntegerData(const std::string& filename, const DataBuffer<int64_t>& data, bool withHeader);
+    static void writeDoubleData(const std::string& filename, const DataBuffer<double>& data, bool withHeader);
+
+    // 文件是否带数据文件头；文件头是否标记为有序（排序时可直接跳过）
+    static bool hasDataHeader(const std::string& filename);
+    static bool isMarkedSorted(const std::string& filename);
+
+    // 以内存映射打开二进制数据（零拷贝；PRIVATE 模式可原地排序）
+    static MappedFile<int64_t> mapIntegerData(const std::string& filename, MapMode mode = MapMode::READ_ONLY);
+    static MappedFile<double> mapDoubleData(const std::string& filename, MapMode mode = MapMode::READ_ONLY);
+
+    // 随机种子：同一种子生成的数据文件逐字节相同，与生成线程数无关
+    static void setSeed(uint64_t value) { seed = value; }
+    static uint64_t getSeed() { return seed; }
+
+    // 生成数据的线程数（0 为硬件线程数）
+    static void setThreadCount(unsigned count) { threadCount = count; }
+    static unsigned getThreadCount() { return threadCount; }
+
+    // 生成整数/浮点数数据时是否写入数据文件头（默认写裸数组）
+    static void setWriteHeader(bool enabled) { writeHeader = enabled; }
+    static bool getWriteHeader() { return writeHeader; }
+
+    // 读入/映射数据的累计耗时（秒），用于把加载时间与排序时间分开统计
+    static void resetLoadSeconds() { loadSeconds = 0; }
+    static double getLoadSeconds() { return loadSeconds; }
+
     // 验证整数文件是否已排序
     static bool verifyIntegerSorted(const std::string& filename);
 
@@ -73,11 +275,14 @@ public:
                         std::function<bool(const T&, const T&)> comp = std::less<T>());
 
 private:
-    // 随机数引擎
-    static std::mt19937_64& getRandomEngine();
+    static double loadSeconds;
+    static bool writeHeader;
+    static uint64_t seed;
+    static unsigned threadCount;
+    static DistributionOptions distributionOptions;
 
-    // 生成随机字符串
-    static std::string generateRandomString(size_t minLen, size_t maxLen);
+    // 生成随机字符串并追加到 out
+    static void appendRandomString(CounterRng& rng, size_t minLen, size_t maxLen, std::string& out);
 
     // 生成更真实的整数分布
     static int64_t generateRealisticInteger();
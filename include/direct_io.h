@@ -0,0 +1,103 @@
+#ifndef DIRECT_IO_H
+#define DIRECT_IO_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <cstdint>
+#include <cstddef>
+
+// 对齐缓冲区池（O_DIRECT 要求缓冲区地址、文件偏移和长度都按块对齐）
+class AlignedBufferPool {
+public:
+    // 对齐粒度（覆盖常见设备的逻辑块大小）
+    static constexpr size_t ALIGNMENT = 4096;
+
+    static AlignedBufferPool& instance();
+
+    // 取得至少 size 字节的对齐缓冲区（大小向上取整到 ALIGNMENT）
+    char* acquire(size_t size);
+
+    // 归还缓冲区，size 需与 acquire 时一致
+    void release(char* buffer, size_t size);
+
+    ~AlignedBufferPool();
+
+private:
+    AlignedBufferPool() = default;
+
+    std::mutex poolMutex;
+    std::multimap<size_t, char*> freeBuffers;
+};
+
+// 从池中借出的对齐缓冲区（RAII）
+class AlignedBuffer {
+public:
+    explicit AlignedBuffer(size_t size);
+    ~AlignedBuffer();
+
+    AlignedBuffer(const AlignedBuffer&) = delete;
+    AlignedBuffer& operator=(const AlignedBuffer&) = delete;
+
+    char* data() { return buffer; }
+    size_t size() const { return capacity; }
+
+private:
+    char* buffer;
+    size_t capacity;
+};
+
+// 可选直接 I/O 的文件：对齐的整块走 O_DIRECT 描述符，
+// 非对齐的头尾片段走普通描述符，因此任意偏移和长度都能正确读写。
+// 文件系统不支持 O_DIRECT 或在 Windows 上时退化为普通 I/O。
+class DirectFile {
+public:
+    DirectFile(const std::string& path, bool write, bool direct);
+    ~DirectFile();
+
+    DirectFile(const DirectFile&) = delete;
+    DirectFile& operator=(const DirectFile&) = delete;
+
+    // 在指定偏移读写（线程安全，可并发访问不相交的区域）
+    void readAt(void* dst, size_t n, uint64_t offset);
+    void writeAt(const void* src, size_t n, uint64_t offset);
+
+    // 预分配/截断文件长度
+    void truncate(uint64_t size);
+
+    // 刷新并关闭，失败时抛出异常
+    void close();
+
+    bool isDirect() const { return directFd != bufferedFd; }
+    const std::string& getPath() const { return path; }
+
+private:
+    std::string path;
+    int bufferedFd;
+    int directFd;
+};
+
+// 顺序写入器：在对齐缓冲区中攒满一块后整块写出，只有起始偏移之前的
+// 非对齐头和最后的非对齐尾经普通 I/O 写入
+class DirectFileWriter {
+public:
+    DirectFileWriter(DirectFile& file, uint64_t startOffset, size_t blockSize = 1 << 20);
+
+    void append(const void* data, size_t n);
+
+    // 写出剩余数据，返回写入的总字节数
+    uint64_t finish();
+
+private:
+    DirectFile& file;
+    AlignedBuffer buffer;
+    uint64_t blockStart;     // buffer[0] 对应的文件偏移（对齐）
+    size_t begin;            // 本块第一个有效字节
+    size_t used;             // 本块已填充到的位置
+    uint64_t written;
+
+    void flush();
+};
+
+#endif // DIRECT_IO_H
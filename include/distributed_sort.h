@@ -0,0 +1,61 @@
+#ifndef DISTRIBUTED_SORT_H
+#define DISTRIBUTED_SORT_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// 单个工作进程的统计
+struct DistributedWorkerStats {
+    uint64_t elements = 0;          // 负责的键区间内的元素数
+    uint64_t bytesSent = 0;         // 洗牌阶段发给其他进程的字节数
+    uint64_t bytesReceived = 0;     // 洗牌阶段从其他进程收到的字节数
+    uint64_t diskBytes = 0;         // 写盘字节数（接收文件、外排序溢写与输出、最终区间）
+    double shuffleSeconds = 0;      // 洗牌阶段耗时
+    double sortSeconds = 0;         // 本地外排序耗时
+    double writeSeconds = 0;        // 写入最终输出耗时
+};
+
+// 最近一次分布式排序的统计
+struct DistributedSortStats {
+    int workerCount = 0;
+    double samplePhaseSeconds = 0;  // 采样与确定分割点
+    double shufflePhaseSeconds = 0; // 按键区间交换数据（最慢的工作进程）
+    double sortPhaseSeconds = 0;    // 各进程本地外排序（最慢的工作进程）
+    double writePhaseSeconds = 0;   // 各进程写入输出区间（最慢的工作进程）
+    uint64_t networkBytes = 0;      // 进程间传输的总字节数
+    uint64_t diskBytes = 0;         // 所有进程的写盘总字节数
+    double networkMBps = 0;         // 洗牌阶段的网络吞吐
+    double diskMBps = 0;            // 洗牌、排序与写出阶段的写盘吞吐
+    std::vector<DistributedWorkerStats> workers;
+};
+
+// 多进程分布式排序（本机）：协调进程把输入按字节均分给 N 个工作进程，
+// 汇总各进程的采样确定分割点；工作进程经 Unix 套接字把元素发给键区间的
+// 所属进程，再用 ExternalSort 排序自己的区间，并写入输出文件的对应位置
+class DistributedSort {
+public:
+    static void sortIntegerFile(const std::string& inputFile, const std::string& outputFile, int workerCount);
+    static void sortDoubleFile(const std::string& inputFile, const std::string& outputFile, int workerCount);
+
+    // 每个工作进程提供的采样数
+    static void setSamplesPerWorker(size_t samples) { samplesPerWorker = samples; }
+
+    // 最近一次排序的统计信息
+    static const DistributedSortStats& getLastStats() { return lastStats; }
+
+    // 打印各阶段吞吐
+    static void printStats();
+
+private:
+    static size_t samplesPerWorker;
+    static DistributedSortStats lastStats;
+
+    // 协调进程：创建工作进程、分发分割点与输出偏移、汇总统计
+    template<typename T>
+    static void sortFile(const std::string& inputFile, const std::string& outputFile,
+                         int workerCount, const std::string& typeName,
+                         void (*localSort)(const std::string&, const std::string&));
+};
+
+#endif // DISTRIBUTED_SORT_H
@@ -2,8 +2,123 @@
 #define EXTERNAL_SORT_H
 
 #include <string>
+#include <iosfwd>
 #include <cstdint>
 #include <vector>
+#include <functional>
+#include "run_codec.h"
+
+class InputChunkReader;
+
+// 阶段1读取输入的方式
+enum class InputReadMode {
+    STREAM,   // ifstream 顺序读取
+    MMAP      // 按 memoryLimit 窗口映射输入文件（非 Windows）
+};
+
+// 顺串在多个临时目录间的放置策略
+enum class TempPlacement {
+    ROUND_ROBIN,      // 轮流放置
+    FREE_SPACE        // 放到剩余空间最多的目录
+};
+
+// 整数/浮点数外排序的输出内容
+enum class MergeOutputMode {
+    ALL,        // 全部元素
+    DISTINCT,   // 仅输出不同的值
+    COUNT       // 输出 (值, uint64 次数) 记录
+};
+
+// 预扫描得到的输入有序性
+enum class PresortKind {
+    UNSORTED,       // 需要完整外排序
+    SORTED,         // 已有序：直接复制
+    REVERSED,       // 逆序：反转输出
+    NATURAL_RUNS    // 由少量有序段拼接而成：跳过阶段1直接归并
+};
+
+// 定长记录排序键的类型
+enum class RecordKeyType {
+    INTEGER,    // 有符号小端整数（宽度 1/2/4/8）
+    DOUBLE,     // 浮点数（宽度 4 为 float，8 为 double）
+    BYTES       // 字节串，按 memcmp 字典序
+};
+
+// 定长二进制记录格式
+struct RecordFormat {
+    size_t recordSize = 0;      // 记录字节数
+    size_t keyOffset = 0;       // 键在记录中的偏移
+    size_t keyWidth = 8;        // 键宽度（字节）
+    RecordKeyType keyType = RecordKeyType::INTEGER;
+};
+
+// 顺序无关的多重集合哈希：逐元素哈希求和，可分段累加后合并
+struct MultisetHash {
+    uint64_t sum = 0;
+    uint64_t count = 0;
+
+    void add(uint64_t hash, uint64_t times = 1) {
+        sum += hash * times;
+        count += times;
+    }
+    void merge(const MultisetHash& other) {
+        sum += other.sum;
+        count += other.count;
+    }
+    bool operator==(const MultisetHash& other) const {
+        return sum == other.sum && count == other.count;
+    }
+};
+
+// 外排序各阶段统计（最近一次排序）
+struct ExternalSortStats {
+    int runCount = 0;               // 初始顺串数
+    double runPhaseSeconds = 0;     // 阶段1：生成顺串耗时
+    double mergePhaseSeconds = 0;   // 阶段2：归并耗时
+    uint64_t spillBytes = 0;        // 写入临时顺串的字节数
+    uint64_t rawSpillBytes = 0;     // 顺串未编码时的字节数
+    size_t memoryBudget = 0;        // 生成顺串结束时的内存预算（字节）
+    size_t mergeFanIn = 0;          // 归并路数上限（0 表示不限）
+    int mergePasses = 0;            // 归并趟数（含最终归并）
+    PresortKind presort = PresortKind::UNSORTED;
+    bool verified = false;          // 写出时做了校验（setVerifyOutput）
+    bool outputOrdered = true;      // 输出有序
+    MultisetHash inputHash;         // 读入阶段计算的输入哈希
+    MultisetHash outputHash;        // 写出时计算的输出哈希（COUNT 模式按次数计）
+    bool distinctOutput = false;    // DISTINCT 模式：输出不是输入的排列
+    int resumedRuns = 0;            // 从检查点恢复时复用的顺串数
+
+    // 输出有序且为输入的一个排列（DISTINCT 模式只看有序）
+    bool outputValid() const {
+        return verified && outputOrdered && (distinctOutput || inputHash == outputHash);
+    }
+};
+
+// 顺串文件描述
+struct RunInfo {
+    std::string path;
+    RunCodecType codec = RunCodecType::NONE;
+    uint64_t count = 0;                    // 元素数
+    uint64_t bytes = 0;                    // 文件字节数
+    std::vector<uint64_t> blockOffsets;    // 每 RunCodec::BLOCK_ELEMENTS 个元素一块：块起始字节
+    std::vector<uint64_t> blockFirstKeys;  // 块首元素（RunCodec::toKey）
+    uint64_t fileOffset = 0;               // 顺串在文件中的起始字节（输入中的自然顺串）
+    bool temporary = true;                 // 是否为可删除的临时文件
+    std::string countPath;                 // COUNT 模式：每个元素的次数（原始 uint64 数组）
+    uint64_t checksum = 0;                 // 顺串文件内容的校验和
+    uint64_t countChecksum = 0;            // 次数文件的校验和
+};
+
+// 可恢复排序的检查点（任务目录下的 manifest.txt）
+struct SortCheckpoint {
+    std::string path;                   // 清单文件路径，空表示未启用
+    std::string jobKey;                 // 输入文件（大小、修改时间）与排序配置
+    bool runsComplete = false;          // 阶段1是否完成
+    uint64_t inputConsumed = 0;         // 已写成顺串的输入元素数
+    MultisetHash inputHash;             // 已消耗输入的哈希（写出校验）
+    int mergePass = 0;                  // 已开始的中间归并趟数
+    std::vector<RunInfo> runs;          // 当前有效的顺串
+};
 
 class ExternalSort {
 public:
@@ -12,31 +127,208 @@ public:
     static void sortDoubleFile(const std::string& inputFile, const std::string& outputFile);
     static void sortStringFile(const std::string& inputFile, const std::string& outputFile);
 
+    // 流式外排序：输入流长度未知（管道/stdin），内存满即溢写顺串，
+    // 归并结果直接写到输出流；期间进度信息输出到 stderr
+    static void sortIntegerStream(std::istream& in, std::ostream& out);
+    static void sortDoubleStream(std::istream& in, std::ostream& out);
+    static void sortStringStream(std::istream& in, std::ostream& out);
+
+    // 定长记录文件按记录内的键排序，整条记录参与顺串生成与归并
+    static void sortRecordFile(const std::string& inputFile, const std::string& outputFile,
+                               const RecordFormat& format);
+
     // 设置内存限制（字节）
     static void setMemoryLimit(size_t limit) { memoryLimit = limit; }
+    static size_t getMemoryLimit() { return memoryLimit; }
+
+    // 自动内存预算：按 cgroup v2 memory.max/memory.current 与 /proc/meminfo
+    // MemAvailable 确定顺串大小和归并路数，内存压力上升时缩小预算
+    static void setAutoMemory(bool enabled) { autoMemory = enabled; }
+    static bool getAutoMemory() { return autoMemory; }
+
+    // 设置输出内容：全部、去重或 (值, 次数)；生成顺串时即合并重复值
+    static void setMergeOutput(MergeOutputMode mode) { mergeOutput = mode; }
+    static MergeOutputMode getMergeOutput() { return mergeOutput; }
+
+    // 整数/浮点数排序前预扫描输入有序性（默认开启）
+    static void setDetectPresorted(bool enabled) { detectPresorted = enabled; }
+
+    // 单次归并最多读取的顺串数（0 表示只受打开文件数限制，超出时先做中间归并）
+    static void setMaxFanIn(size_t fanIn) { maxFanIn = fanIn; }
+
+    // 设置顺串生成的工作线程数（0 表示使用硬件并发数）
+    static void setThreadCount(unsigned count) { threadCount = count; }
+    static unsigned getThreadCount();
+
+    // 设置整数/浮点数临时顺串的编码方式
+    static void setRunCodec(RunCodecType codec) { runCodec = codec; }
+    static RunCodecType getRunCodec() { return runCodec; }
+
+    // 设置整数/浮点数顺串生成的输入读取方式
+    static void setInputMode(InputReadMode mode) { inputMode = mode; }
+    static InputReadMode getInputMode() { return inputMode; }
+
+    // 整数/浮点数顺串读写与最终输出使用直接 I/O（O_DIRECT，绕过页缓存）
+    static void setDirectIO(bool enabled) { directIO = enabled; }
+    static bool getDirectIO() { return directIO; }
+
+    // 设置临时目录列表（每个目录对应一块溢写磁盘，默认当前目录）
+    static void setTempDirectories(const std::vector<std::string>& dirs) {
+        tempRoots = dirs.empty() ? std::vector<std::string>{"."} : dirs;
+    }
+    static void setTempPlacement(TempPlacement placement) { tempPlacement = placement; }
+
+    // 可恢复排序（整数/浮点数文件）：任务目录名由输入、输出路径确定，每写完一个
+    // 顺串或一组中间归并就更新带校验和的清单；失败时保留，重新运行同一任务时
+    // 复用校验通过的顺串，从最后完成的位置继续
+    static void setResumable(bool enabled) { resumable = enabled; }
+    static bool getResumable() { return resumable; }
+
+    // 写出时校验：读入时计算输入哈希，写出时检查顺序并计算输出哈希，
+    // 结果见 getLastStats()（整数/浮点数/字符串）
+    static void setVerifyOutput(bool enabled) { verifyOutput = enabled; }
+    static bool getVerifyOutput() { return verifyOutput; }
+
+    // 设置进度信息的输出流（默认 std::cout）
+    static void setProgressStream(std::ostream& out) { progressOut = &out; }
+
+    // 最近一次排序的统计信息
+    static const ExternalSortStats& getLastStats() { return lastStats; }
 
 private:
     static size_t memoryLimit;
+    static unsigned threadCount;
+    static RunCodecType runCodec;
+    static InputReadMode inputMode;
+    static bool directIO;
+    static std::vector<std::string> tempRoots;
+    static TempPlacement tempPlacement;
+    static std::vector<int64_t> jobFreeSpace;
+    static bool autoMemory;
+    static bool detectPresorted;
+    static MergeOutputMode mergeOutput;
+    static std::ostream* progressOut;
+    static bool verifyOutput;
+    static bool resumable;
+    static SortCheckpoint checkpoint;
+
+    // 当前文件排序的数据区起始字节（输入/输出带数据文件头时跳过文件头）
+    static uint64_t inputOffset;
+    static uint64_t outputOffset;
+
+    static std::ostream& progress() { return *progressOut; }
+    static size_t maxFanIn;
+
+    // 自动模式下重新计算内存预算（heldBytes 为本任务已占用的内存）
+    static size_t refreshMemoryBudget(size_t heldBytes, bool shrinkOnly);
+    static size_t getMergeFanIn();
+
+    // 在每个临时根目录下创建本次任务的唯一目录（resumeKey 非空时目录名固定，
+    // 已存在则沿用）
+    static std::vector<std::string> createJobDirectories(const std::string& tempTag,
+                                                         const std::string& resumeKey = "");
+    static void removeJobDirectories(const std::vector<std::string>& dirs);
+
+    // 写入/读取检查点清单；读取时逐个校验顺串，任一不符则返回 false
+    static void saveCheckpoint();
+    static bool loadCheckpoint();
+
+    // 为下一个顺串选择临时目录
+    static size_t pickTempDirectory(size_t runIndex, uint64_t runBytes, size_t dirCount);
+    static ExternalSortStats lastStats;
+
+    // 整数/浮点数外排序的公共流程
+    template<typename T>
+    static void sortBinaryFile(const std::string& inputFile, const std::string& outputFile,
+                               const std::string& typeName, const std::string& tempTag,
+                               bool (*compare)(const T&, const T&));
+
+    // 流式整数/浮点数外排序的公共流程
+    template<typename T>
+    static void sortBinaryStream(std::istream& in, std::ostream& out,
+                                 const std::string& typeName, const std::string& tempTag,
+                                 bool (*compare)(const T&, const T&));
+
+    // 流式预扫描：识别已有序、逆序或由有序段拼接的输入
+    template<typename T>
+    static PresortKind scanPresorted(const std::string& inputFile,
+                                     std::vector<RunInfo>& naturalRuns,
+                                     bool (*compare)(const T&, const T&) = nullptr);
+
+    // 复制（或反转）已有序的输入
+    template<typename T>
+    static void copyInput(const std::string& inputFile, const std::string& outputFile, bool reverse);
+
+    // 多线程排序一个顺串缓冲区（分片排序后两两归并）
+    template<typename T, typename Compare>
+    static void parallelSort(T* data, size_t count, Compare comp);
+
+    // parallelSort 归并时每个元素额外占用的字节数（inplace_merge 的临时缓冲
+    // 至多为半个缓冲区），生成顺串时计入内存预算
+    static size_t sortScratchBytes(size_t elementBytes);
 
     // 分割文件为有序的顺串
+    // （inputSize 为输入字节数，未知时为 -1）
     template<typename T>
-    static int createInitialRuns(const std::string& inputFile,
-                                const std::string& tempDir,
-                                bool (*compare)(const T&, const T&) = nullptr);
+    static std::vector<RunInfo> createInitialRuns(InputChunkReader& inFile, int64_t inputSize,
+                                                  const std::vector<std::string>& tempDirs,
+                                                  bool (*compare)(const T&, const T&) = nullptr);
 
     // 多路归并
     template<typename T>
-    static void mergeRuns(const std::vector<std::string>& runFiles,
-                         const std::string& outputFile,
-                         bool (*compare)(const T&, const T&) = nullptr);
+    static void mergeRuns(const std::vector<RunInfo>& runs,
+                          const std::string& outputFile,
+                          bool (*compare)(const T&, const T&) = nullptr);
+
+    // 多路归并，输出交给 write 回调，返回输出的元素数
+    template<typename T>
+    static uint64_t mergeRunsInto(const std::vector<RunInfo>& runs,
+                                  const std::function<void(const char*, size_t)>& write,
+                                  bool (*compare)(const T&, const T&) = nullptr);
+
+    // 顺串数超过归并路数时，逐趟归并成更长的顺串
+    template<typename T>
+    static std::vector<RunInfo> reduceRuns(std::vector<RunInfo> runs,
+                                           const std::vector<std::string>& tempDirs,
+                                           size_t fanIn,
+                                           bool (*compare)(const T&, const T&) = nullptr);
+
+    // 按键范围切分顺串的并行多路归并（pwrite 写入同一输出文件）
+    template<typename T>
+    static void parallelMergeRuns(const std::vector<RunInfo>& runs,
+                                  const std::string& outputFile,
+                                  bool (*compare)(const T&, const T&) = nullptr);
 
     // 读取一批数据
     template<typename T>
     static std::vector<T> readChunk(const std::string& filename, size_t chunkSize);
 
-    // 写入一批数据
-    template<typename T>
-    static void writeChunk(const std::string& filename, const std::vector<T>& data);
+    // 定长记录外排序的公共流程（Key 在编译期确定键的提取与比较）
+    template<typename Key>
+    static void sortRecordsByKey(const std::string& inputFile, const std::string& outputFile,
+                                 size_t recordSize, const Key& key);
+
+    // 生成定长记录顺串：小记录直接排序，大记录按（键前缀，下标）标签排序
+    template<typename Key>
+    static std::vector<std::string> createRecordRuns(const std::string& inputFile,
+                                                     const std::vector<std::string>& tempDirs,
+                                                     size_t recordSize, const Key& key);
+
+    // 定长记录多路归并，返回输出的记录数
+    template<typename Key>
+    static uint64_t mergeRecordRuns(const std::vector<std::string>& runFiles,
+                                    const std::string& outputFile,
+                                    size_t recordSize, const Key& key);
+
+    // 按字节预算生成字符串顺串（二进制字符串格式）；next(value) 取下一个输入
+    // 字符串，输入结束时返回 false
+    template<typename NextString>
+    static std::vector<std::string> createStringRuns(NextString next,
+                                                     const std::vector<std::string>& tempDirs);
+
+    // 字符串多路归并（映射顺串，缓存键前缀），按行分隔的输出攒成大块交给 write
+    static void mergeStringRuns(const std::vector<std::string>& runFiles,
+                                const std::function<void(const char*, size_t)>& write);
 
     // 比较函数
     static bool compareInt(const int64_t& a, const int64_t& b) { return a < b; }
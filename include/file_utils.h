@@ -2,8 +2,333 @@
 #define FILE_UTILS_H
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <utility>
+#include <functional>
+#include <type_traits>
+#include <atomic>
+#include <chrono>
+
+// 无参构造时不做值初始化的分配器：resize/构造出的元素保持未初始化，
+// 大缓冲区的页面由随后并行写入的各线程各自首次触碰
+template<typename T>
+class DefaultInitAllocator : public std::allocator<T> {
+public:
+    template<typename U>
+    struct rebind {
+        using other = DefaultInitAllocator<U>;
+    };
+
+    using std::allocator<T>::allocator;
+
+    template<typename U>
+    void construct(U* p) noexcept(std::is_nothrow_default_constructible<U>::value) {
+        ::new (static_cast<void*>(p)) U;
+    }
+
+    template<typename U, typename... Args>
+    void construct(U* p, Args&&... args) {
+        ::new (static_cast<void*>(p)) U(std::forward<Args>(args)...);
+    }
+};
+
+// 从文件整块读入的数据缓冲区（元素不预先清零）
+template<typename T>
+using DataBuffer = std::vector<T, DefaultInitAllocator<T>>;
+
+// 文件映射方式
+enum class MapMode {
+    READ_ONLY,    // 只读
+    PRIVATE,      // 写时复制：可原地修改，不写回文件
+    SHARED        // 读写：修改写回文件（可新建指定大小的文件）
+};
+
+// 映射提示（可按位组合）
+enum MapHint : unsigned {
+    MAP_HINT_NONE = 0,
+    MAP_HINT_POPULATE = 1,      // 建立映射时预读全部页面（MAP_POPULATE）
+    MAP_HINT_HUGE_PAGES = 2,    // 建议使用透明大页（MADV_HUGEPAGE）
+    MAP_HINT_SEQUENTIAL = 4     // 顺序访问（MADV_SEQUENTIAL）
+};
+
+// 整个文件的内存映射（按字节）；没有 mmap 的平台上退化为读入缓冲区，
+// SHARED 模式在 sync()/close() 时写回
+class MappedRegion {
+public:
+    MappedRegion() = default;
+
+    // SHARED 模式下 bytes > 0 时创建（或截断）文件为该大小，否则映射现有文件
+    MappedRegion(const std::string& path, MapMode mode, uint64_t bytes = 0, unsigned hints = MAP_HINT_NONE);
+    ~MappedRegion();
+
+    MappedRegion(MappedRegion&& other) noexcept;
+    MappedRegion& operator=(MappedRegion&& other) noexcept;
+    MappedRegion(const MappedRegion&) = delete;
+    MappedRegion& operator=(const MappedRegion&) = delete;
+
+    char* data() const { return base; }
+    uint64_t size() const { return length; }
+
+    // SHARED 模式：把修改同步写回文件（msync）
+    void sync();
+
+    // 解除映射
+    void close();
+
+private:
+    std::string path;
+    MapMode mode = MapMode::READ_ONLY;
+    char* base = nullptr;
+    uint64_t length = 0;
+    std::vector<char> fallback;
+};
+
+// 输出文件：按偏移 pwrite/pwritev 写入，多个线程可并发写不相交的区域；
+// 打开到 close() 之间写出的字节数与耗时计入 FileUtils 的写出统计
+class OutputFile {
+public:
+    // 创建（或截断）文件
+    explicit OutputFile(const std::string& path);
+    ~OutputFile();
+
+    OutputFile(const OutputFile&) = delete;
+    OutputFile& operator=(const OutputFile&) = delete;
+
+    void writeAt(const void* data, size_t n, uint64_t offset);
+
+    // 聚集写：各片段依次写到 offset 起的连续位置，不先拼接
+    void writevAt(const std::string_view* parts, size_t count, uint64_t offset);
+
+    // 预分配/截断文件长度
+    void truncate(uint64_t size);
+
+    // 关闭文件并记录写出统计，失败时抛出异常
+    void close();
+
+    const std::string& getPath() const { return path; }
+
+private:
+    std::string path;
+    int fd;
+    std::atomic<uint64_t> written{0};
+    std::chrono::steady_clock::time_point opened;
+};
+
+// 块写入器：小片段攒成整块（默认 FileUtils::getWriteBlockSize()）后写到
+// startOffset 起的连续位置；不小于一块的片段与已缓冲内容合成一次聚集写，不再复制
+class BlockWriter {
+public:
+    BlockWriter(OutputFile& file, uint64_t startOffset, size_t blockSize = 0);
+
+    void write(const char* data, size_t n);
+
+    // 写出一行（自动补换行）
+    void writeLine(std::string_view line) {
+        if (used + line.size() < buffer.size()) {
+            memcpy(buffer.data() + used, line.data(), line.size());
+            used += line.size();
+            buffer[used++] = '\n';
+            return;
+        }
+        write(line.data(), line.size());
+        write("\n", 1);
+    }
+
+    // 写出剩余数据，返回写入的总字节数
+    uint64_t finish();
+
+private:
+    OutputFile& file;
+    std::vector<char> buffer;
+    size_t used;
+    uint64_t offset;         // 下一次写出的文件偏移
+    uint64_t written;
+
+    void flush();
+};
+
+// 数据文件（.dat）元素类型
+enum class ElementType : uint8_t {
+    UNKNOWN = 0,
+    INT64 = 1,
+    DOUBLE = 2
+};
+
+// 数据文件头标志
+enum DataFlag : uint8_t {
+    DATA_FLAG_SORTED = 1        // 数据按升序排列
+};
+
+// 可选的 64 字节数据文件头，数据紧随其后；没有文件头的文件按裸数组读取。
+// 魔数仿照 PNG：含高位字节与 CR LF、^Z，作为 int64/double 数据几乎不可能出现
+struct DataFileHeader {
+    static constexpr char MAGIC[8] = {'\x89', 'S', 'D', 'A', 'T', '\r', '\n', '\x1a'};
+    static const uint8_t VERSION = 1;
+    static const uint8_t LITTLE_ENDIAN_ORDER = 1;
+    static const uint8_t BIG_ENDIAN_ORDER = 2;
+
+    char magic[8];
+    uint8_t version;
+    ElementType type;
+    uint8_t endianness;
+    uint8_t flags;              // DataFlag
+    uint8_t padding[4];
+    uint64_t count;             // 元素个数
+    uint64_t minBits;           // 最小/最大元素的位模式（count > 0 时有效）
+    uint64_t maxBits;
+    uint64_t checksum;          // 与元素顺序无关的校验和，排序前后不变
+    uint8_t reserved[16];
+
+    bool sorted() const { return (flags & DATA_FLAG_SORTED) != 0; }
+
+    template<typename T>
+    static constexpr ElementType typeOf() {
+        return std::is_floating_point<T>::value ? ElementType::DOUBLE : ElementType::INT64;
+    }
+
+    // 本机字节序
+    static uint8_t nativeEndianness();
+
+    // 从文件开头的字节解析文件头：魔数、版本、字节序、元素类型或个数与文件
+    // 大小任一不符时按裸数组处理，返回 false；文件头有效但元素类型与
+    // expected（非 UNKNOWN 时）不同则抛出异常
+    static bool parse(const char* bytes, uint64_t fileSize, ElementType expected, DataFileHeader& header);
+};
+
+static_assert(sizeof(DataFileHeader) == 64, "DataFileHeader must stay 64 bytes");
+
+// 逐批统计文件头：个数、是否有序、最小/最大值与校验和
+template<typename T>
+class DataHeaderBuilder {
+public:
+    void add(const T* data, size_t count);
+
+    // 并入紧接在本段之后的一段数据的统计（分块并行统计后按块序合并）
+    void merge(const DataHeaderBuilder& next);
+
+    DataFileHeader header() const;
+
+private:
+    uint64_t count = 0;
+    bool ordered = true;
+    T minValue{};
+    T maxValue{};
+    T first{};
+    T last{};
+    uint64_t checksum = 0;
+};
+
+// 顺序写出数据文件；带文件头时先留出文件头的位置，边写边统计，finish() 时回填
+template<typename T>
+class DataFileWriter {
+public:
+    DataFileWriter(const std::string& path, bool withHeader);
+
+    void write(const T* data, size_t count);
+
+    // 回填文件头并关闭文件
+    void finish();
+
+private:
+    OutputFile file;
+    BlockWriter writer;
+    bool withHeader;
+    DataHeaderBuilder<T> builder;
+};
+
+// 定长元素二进制文件的零拷贝视图（类似 span）；映射已有文件时跳过数据文件头
+template<typename T>
+class MappedFile {
+public:
+    MappedFile() = default;
+
+    // SHARED 模式下 count > 0 时创建含 count 个元素的文件
+    explicit MappedFile(const std::string& path, MapMode mode = MapMode::READ_ONLY,
+                        size_t count = 0, unsigned hints = MAP_HINT_NONE)
+        : region(path, mode, static_cast<uint64_t>(count) * sizeof(T), hints) {
+        bool created = mode == MapMode::SHARED && count > 0;
+        if (!created && region.size() > 0 &&
+            DataFileHeader::parse(region.data(), region.size(), DataFileHeader::typeOf<T>(), fileHeader)) {
+            headerBytes = sizeof(DataFileHeader);
+        }
+    }
+
+    T* data() const { return reinterpret_cast<T*>(region.data() + headerBytes); }
+    size_t size() const { return (region.size() - headerBytes) / sizeof(T); }
+    bool empty() const { return size() == 0; }
+
+    T* begin() const { return data(); }
+    T* end() const { return data() + size(); }
+    T& operator[](size_t index) const { return data()[index]; }
+
+    void sync() { region.sync(); }
+    void close() { region.close(); headerBytes = 0; }
+
+    // 文件是否带数据文件头
+    bool hasHeader() const { return headerBytes > 0; }
+    const DataFileHeader& header() const { return fileHeader; }
+
+private:
+    MappedRegion region;
+    uint64_t headerBytes = 0;
+    DataFileHeader fileHeader{};
+};
+
+// 按行切分的文本文件：整个文件映射为一块，各行以 string_view 指向映射；
+// 大文件按块多线程切分（memchr 查找换行，块边界对齐到下一行首）
+class TextLines {
+public:
+    explicit TextLines(const std::string& path, unsigned threads = 0);
+
+    size_t size() const { return lines.size(); }
+    std::string_view operator[](size_t index) const { return lines[index]; }
+    std::vector<std::string_view>::const_iterator begin() const { return lines.begin(); }
+    std::vector<std::string_view>::const_iterator end() const { return lines.end(); }
+
+    // 复制为独立的字符串
+    std::vector<std::string> toStrings() const;
+
+private:
+    MappedRegion region;
+    std::vector<std::string_view> lines;
+};
+
+// 二进制字符串文件：文件头（魔数、字符串个数、数据区字节数）、偏移表
+// （count + 1 项，相对数据区起点）与数据区；映射后即可按下标零拷贝访问
+struct BinaryStringHeader {
+    char magic[8];
+    uint64_t count;
+    uint64_t dataBytes;
+};
+
+class BinaryStrings {
+public:
+    static constexpr char MAGIC[8] = {'S', 'T', 'R', 'B', 'I', 'N', '0', '1'};
+
+    explicit BinaryStrings(const std::string& path);
+
+    size_t size() const { return count; }
+    uint64_t dataBytes() const { return count > 0 ? offsets[count] : 0; }
+    std::string_view operator[](size_t index) const {
+        return std::string_view(blob + offsets[index], offsets[index + 1] - offsets[index]);
+    }
+
+    // 第 index 个字符串在数据区中的起点（index == size() 时为数据区末尾）
+    uint64_t offset(size_t index) const { return offsets[index]; }
+    const char* data() const { return blob; }
+
+private:
+    MappedRegion region;
+    const uint64_t* offsets = nullptr;
+    const char* blob = nullptr;
+    uint64_t count = 0;
+};
 
 class FileUtils {
 public:
@@ -16,20 +341,77 @@ public:
     // 获取文件大小
     static int64_t getFileSize(const std::string& filename);
 
-    // 读取二进制文件
+    // 获取路径所在磁盘的可用空间（字节），失败返回 -1
+    static int64_t getAvailableSpace(const std::string& path);
+
+    // 读取二进制文件（跳过数据文件头）：大文件按对齐的区段多线程 pread 直接读入结果
+    // （缓冲区不预先清零，页面由各读线程首次触碰）
     template<typename T>
-    static std::vector<T> readBinaryFile(const std::string& filename);
+    static DataBuffer<T> readBinaryFile(const std::string& filename);
+
+    // 多线程把文件中 offset 起的 bytes 字节读到 dest（区段边界按 4KB 对齐，各线程 pread）
+    static void readParallel(const std::string& filename, char* dest, uint64_t bytes, uint64_t offset);
 
     // 写入二进制文件
     template<typename T>
     static void writeBinaryFile(const std::string& filename, const std::vector<T>& data);
 
+    // 写出数据文件（数组一次写出）：withHeader 时带数据文件头，数据区按线程切段并行写出
+    template<typename T>
+    static void writeDataFile(const std::string& filename, const T* data, size_t count, bool withHeader);
+
+    // 多线程把连续字节写到 offset 起的位置（区段边界按 4KB 对齐，各线程 pwrite）
+    static void writeParallel(OutputFile& file, const char* data, uint64_t bytes, uint64_t offset);
+
+    // 按行写出文本，at(i) 返回第 i 行：各线程先统计本段字节数，
+    // 再从前缀和算出的偏移处用各自的 BlockWriter 写出本段
+    static void writeLines(const std::string& filename, size_t count,
+                           const std::function<std::string_view(size_t)>& at);
+
+    // 输出块大小（字节，默认 1MB）与并行读/写的线程数（0 为硬件线程数，1 为单线程）
+    static void setWriteBlockSize(size_t bytes);
+    static size_t getWriteBlockSize() { return writeBlockSize; }
+    static void setWriteThreads(unsigned threads) { writeThreads = threads; }
+    static unsigned getWriteThreads() { return writeThreads; }
+    static void setReadThreads(unsigned threads) { readThreads = threads; }
+    static unsigned getReadThreads() { return readThreads; }
+
+    // 写出统计：累计的输出字节数与输出文件打开到关闭的耗时（秒）
+    static void resetWriteStats();
+    static void recordWrite(uint64_t bytes, double seconds);
+    static uint64_t getWriteBytes();
+    static double getWriteSeconds();
+
+    // 读取数据文件头；裸数组文件返回 false，文件头无效时抛出异常
+    static bool readDataHeader(const std::string& filename, DataFileHeader& header,
+                               ElementType expected = ElementType::UNKNOWN);
+
+    // 数据区在文件中的起始字节：带文件头时为 sizeof(DataFileHeader)，否则为 0
+    static uint64_t dataOffset(const std::string& filename);
+
+    // 覆盖写入文件开头的数据文件头（数据已写在其后）
+    static void writeDataHeader(const std::string& filename, const DataFileHeader& header);
+
     // 读取文本文件
     static std::vector<std::string> readTextFile(const std::string& filename);
 
     // 写入文本文件
     static void writeTextFile(const std::string& filename, const std::vector<std::string>& data);
 
+    // 是否为二进制字符串文件（检查魔数）
+    static bool isBinaryStringFile(const std::string& filename);
+
+    // 写出二进制字符串文件，at(i) 返回第 i 个字符串
+    static void writeBinaryStrings(const std::string& filename, size_t count,
+                                   const std::function<std::string_view(size_t)>& at);
+
+    // 文本（每行一个）与二进制字符串格式互相转换
+    static void textToBinaryStrings(const std::string& textFile, const std::string& binaryFile);
+    static void binaryToTextStrings(const std::string& binaryFile, const std::string& textFile);
+
+    // 字符串个数：二进制格式只读文件头，文本格式按行计数
+    static uint64_t countStrings(const std::string& filename);
+
     // 清空目录
     static bool cleanDirectory(const std::string& path);
 
@@ -38,6 +420,11 @@ public:
 
     // 获取临时文件名
     static std::string getTempFilename(const std::string& prefix, int index);
+
+private:
+    static size_t writeBlockSize;
+    static unsigned writeThreads;
+    static unsigned readThreads;
 };
 
 #endif // FILE_UTILS_H
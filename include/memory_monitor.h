@@ -35,6 +35,13 @@ public:
     // 获取详细内存信息
     static void printMemoryInfo();
 
+    // 系统可用物理内存（Linux: /proc/meminfo MemAvailable），未知时返回 0
+    static size_t getAvailableSystemMemory();
+
+    // 当前 cgroup v2 的剩余内存额度（memory.max - memory.current），
+    // 无限制或无法读取时返回 SIZE_MAX
+    static size_t getCgroupMemoryHeadroom();
+
 private:
     // 获取当前进程内存使用量的内部实现
     static size_t getCurrentMemoryUsageImpl();
@@ -3,6 +3,8 @@
 
 #include <vector>
 #include <string>
+#include "string_column.h"
+#include "file_utils.h"
 #include <functional>
 
 class MergeSort {
@@ -13,21 +15,28 @@ public:
     // 浮点数排序
     static void sortInMemory(std::vector<double>& arr);
 
+    // 从文件读入的整数/浮点数缓冲区排序
+    static void sortInMemory(DataBuffer<int64_t>& arr);
+    static void sortInMemory(DataBuffer<double>& arr);
+
     // 字符串排序
     static void sortInMemory(std::vector<std::string>& arr);
 
+    // 字符串列排序：只移动带键前缀的句柄，最后按句柄顺序重排整列
+    static void sortInMemory(StringColumn& column);
+
     // 文件排序接口
     static void sortIntegerFile(const std::string& inputFile, const std::string& outputFile);
     static void sortDoubleFile(const std::string& inputFile, const std::string& outputFile);
     static void sortStringFile(const std::string& inputFile, const std::string& outputFile);
 
     // 递归归并排序
-    template<typename T, typename Compare>
-    static void mergeSortRecursive(std::vector<T>& arr, int left, int right, Compare comp);
+    template<typename T, typename Alloc, typename Compare>
+    static void mergeSortRecursive(std::vector<T, Alloc>& arr, int left, int right, Compare comp);
 
     // 归并函数
-    template<typename T, typename Compare>
-    static void merge(std::vector<T>& arr, int left, int mid, int right, Compare comp);
+    template<typename T, typename Alloc, typename Compare>
+    static void merge(std::vector<T, Alloc>& arr, int left, int mid, int right, Compare comp);
 
     // 迭代归并排序
     template<typename T, typename Compare>
@@ -3,20 +3,33 @@
 
 #include <vector>
 #include <string>
+#include "string_column.h"
+#include "file_utils.h"
 #include <functional>
 #include <stack>
 
 class QuickSort {
 public:
+    // 基准测试结果中的算法名：三数取中基准与堆排序兜底，与首元素基准时期的
+    // QuickSort 结果分开记录
+    static constexpr const char* BENCHMARK_NAME = "QuickSort-M3";
+
     // 整数排序
     static void sortInMemory(std::vector<int64_t>& arr);
 
     // 浮点数排序
     static void sortInMemory(std::vector<double>& arr);
 
+    // 从文件读入的整数/浮点数缓冲区排序
+    static void sortInMemory(DataBuffer<int64_t>& arr);
+    static void sortInMemory(DataBuffer<double>& arr);
+
     // 字符串排序
     static void sortInMemory(std::vector<std::string>& arr);
 
+    // 字符串列排序：只移动带键前缀的句柄，最后按句柄顺序重排整列
+    static void sortInMemory(StringColumn& column);
+
     // 文件排序接口
     static void sortIntegerFile(const std::string& inputFile, const std::string& outputFile);
     static void sortDoubleFile(const std::string& inputFile, const std::string& outputFile);
@@ -34,9 +47,10 @@ public:
     template<typename T, typename Compare>
     static int partition(std::vector<T>& arr, int low, int high, Compare comp);
 
-    // 三路快速排序（处理重复元素）
-    template<typename T, typename Compare>
-    static void threeWayQuickSort(std::vector<T>& arr, int low, int high, Compare comp);
+    // 三路快速排序（处理重复元素）：三数取中选基准，递归深度超过
+    // depthLimit（负数表示按 2·log2(n) 计算）时改用堆排序，最坏 O(n log n)
+    template<typename T, typename Alloc, typename Compare>
+    static void threeWayQuickSort(std::vector<T, Alloc>& arr, int low, int high, Compare comp, int depthLimit = -1);
 };
 
 #endif // QUICK_SORT_H
@@ -3,19 +3,31 @@
 
 #include <vector>
 #include <string>
+#include "string_column.h"
+#include "file_utils.h"
 
 class RadixSort {
 public:
     // 整数排序（只支持非负整数）
     static void sortInMemory(std::vector<int64_t>& arr);
 
+    // 从文件读入的整数缓冲区排序
+    static void sortInMemory(DataBuffer<int64_t>& arr);
+
     // 字符串排序
     static void sortInMemory(std::vector<std::string>& arr);
 
+    // 字符串列排序：只移动带键前缀的句柄，最后按句柄顺序重排整列
+    static void sortInMemory(StringColumn& column);
+
     // 文件排序接口
     static void sortIntegerFile(const std::string& inputFile, const std::string& outputFile);
     static void sortStringFile(const std::string& inputFile, const std::string& outputFile);
 
+    // 整数基数排序（负数取反后单独排序），两种容器共用
+    template<typename Alloc>
+    static void sortIntegers(std::vector<int64_t, Alloc>& arr);
+
     // 获取最大值
     template<typename T>
     static T getMax(const std::vector<T>& arr);
@@ -25,6 +37,16 @@ public:
 
     // 字符串基数排序的计数排序
     static void countingSort(std::vector<std::string>& arr, int pos);
+
+    // 句柄按键前缀第 byte 字节（0 为最高字节）的计数排序
+    static void countingSort(std::vector<StringColumn::Handle>& handles, int byte);
+
+    // 句柄按 prefix 的 LSD 基数排序
+    static void sortByPrefix(std::vector<StringColumn::Handle>& handles);
+
+    // prefix 相同的组按第 depth 字节起的下一个 8 字节块继续基数排序（MSD）
+    static void sortTieGroups(const StringColumn& column, std::vector<StringColumn::Handle>& handles,
+                              size_t depth);
 };
 
 #endif // RADIX_SORT_H
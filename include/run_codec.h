@@ -0,0 +1,47 @@
+#ifndef RUN_CODEC_H
+#define RUN_CODEC_H
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+// 临时顺串的编码方式
+enum class RunCodecType {
+    NONE,             // 原始 8 字节元素
+    DELTA_VARINT      // 分块差分 + varint
+};
+
+// 有序顺串编解码（无外部依赖）
+// 块格式: [uint32 元素数][uint32 负载字节数][uint64 首键][varint 差分...]
+class RunCodec {
+public:
+    // 每块最多包含的元素数
+    static constexpr size_t BLOCK_ELEMENTS = 4096;
+
+    // 块头大小（字节）
+    static constexpr size_t HEADER_BYTES = 16;
+
+    // 块头
+    struct BlockHeader {
+        uint32_t count;
+        uint32_t payloadBytes;
+        uint64_t firstKey;
+    };
+
+    // 编码一块键，追加到 out
+    static void encodeBlock(const uint64_t* keys, size_t count, std::vector<char>& out);
+
+    // 解析块头
+    static BlockHeader readHeader(const char* block);
+
+    // 解码一块（block 指向块头），返回块后的位置
+    static const char* decodeBlock(const char* block, uint64_t* keys);
+
+    // 保序映射：元素 <-> 无符号键（相邻有序元素的差分很小）
+    static uint64_t toKey(int64_t value);
+    static uint64_t toKey(double value);
+    static void fromKey(uint64_t key, int64_t& value);
+    static void fromKey(uint64_t key, double& value);
+};
+
+#endif // RUN_CODEC_H
@@ -3,6 +3,7 @@
 
 #include <vector>
 #include <string>
+#include "string_column.h"
 #include <functional>
 
 class ShellSort {
@@ -16,6 +17,9 @@ public:
     // 字符串排序
     static void sortInMemory(std::vector<std::string>& arr);
 
+    // 字符串列排序：只移动带键前缀的句柄，最后按句柄顺序重排整列
+    static void sortInMemory(StringColumn& column);
+
     // 文件排序接口
     static void sortIntegerFile(const std::string& inputFile, const std::string& outputFile);
     static void sortDoubleFile(const std::string& inputFile, const std::string& outputFile);
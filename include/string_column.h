@@ -0,0 +1,77 @@
+#ifndef STRING_COLUMN_H
+#define STRING_COLUMN_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+// 字符串列：所有字节连续存放在一块 arena 中，另存每个字符串的偏移与长度，
+// 避免 vector<std::string> 逐个分配带来的指针追逐与缓存失效
+class StringColumn {
+public:
+    // 排序句柄（16 字节）：排序时只移动句柄，前缀不同的比较不访问 arena
+    struct Handle {
+        uint64_t prefix;    // 前 8 字节，大端、不足补零
+        uint32_t index;     // 字符串在列中的下标
+        uint32_t length;    // 字符串长度
+    };
+
+    // 句柄比较器，供各排序算法的模板直接内联
+    struct HandleLess {
+        const StringColumn* column;
+        bool operator()(const Handle& a, const Handle& b) const { return column->less(a, b); }
+    };
+
+    StringColumn() = default;
+
+    // 从文本文件读取（每行一个字符串），整个文件一次复制进 arena
+    static StringColumn fromTextFile(const std::string& path);
+
+    // 从二进制字符串文件读取：数据区与偏移表直接复制，无需扫描换行
+    static StringColumn fromBinaryFile(const std::string& path);
+
+    void reserve(size_t count, size_t bytes);
+    void push_back(std::string_view value);
+    void clear();
+
+    size_t size() const { return offsets.size(); }
+    bool empty() const { return offsets.empty(); }
+    std::string_view operator[](size_t index) const {
+        return std::string_view(arena.data() + offsets[index], lengths[index]);
+    }
+
+    // 占用的内存（arena 与偏移/长度数组）
+    size_t memoryBytes() const;
+
+    // 按当前顺序生成排序句柄
+    std::vector<Handle> makeHandles() const;
+    HandleLess handleLess() const { return HandleLess{this}; }
+
+    // 按句柄顺序重排整列（重建 arena，使排序后的字符串重新连续）
+    void permute(const std::vector<Handle>& order);
+
+    // 按行写出；给出句柄时按句柄顺序写出
+    void writeTextFile(const std::string& path) const;
+    void writeTextFile(const std::string& path, const std::vector<Handle>& order) const;
+
+    // 大端、补零的 8 字节前缀：按整数比较与按字节（unsigned char）字典序一致
+    static uint64_t keyPrefix(std::string_view value);
+
+    // 句柄比较：前缀相同时只比较前缀之后的部分
+    bool less(const Handle& a, const Handle& b) const {
+        if (a.prefix != b.prefix) return a.prefix < b.prefix;
+        uint32_t skip = std::min<uint32_t>(8, std::min(a.length, b.length));
+        std::string_view left(arena.data() + offsets[a.index] + skip, a.length - skip);
+        std::string_view right(arena.data() + offsets[b.index] + skip, b.length - skip);
+        return left < right;
+    }
+
+private:
+    std::vector<char> arena;
+    std::vector<uint64_t> offsets;
+    std::vector<uint32_t> lengths;
+};
+
+#endif // STRING_COLUMN_H
@@ -4,6 +4,7 @@
 #include "merge_sort.h"
 #include "radix_sort.h"
 #include "external_sort.h"
+#include "distributed_sort.h"
 #include "benchmark.h"
 #include "memory_monitor.h"
 #include "file_utils.h"
@@ -14,6 +15,11 @@
 #include <iomanip>
 #include <fstream>
 
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#endif
+
 using namespace std;
 using namespace chrono;
 
@@ -44,6 +50,7 @@ void showMainMenu() {
     cout << "6. 生成真实数据" << endl;
     cout << "7. 运行完整性能测试" << endl;
     cout << "8. 显示系统信息" << endl;
+    cout << "9. 运行输入分布测试" << endl;
     cout << "0. 退出系统" << endl;
     cout << "请选择: ";
 }
@@ -71,6 +78,16 @@ void showDataSizeMenu() {
     cout << "请选择: ";
 }
 
+// 显示输入分布菜单（序号从 1 起，对应 DataGenerator::allDistributions）
+void showDistributionMenu() {
+    cout << "\n选择输入分布:" << endl;
+    auto distributions = DataGenerator::allDistributions();
+    for (size_t i = 0; i < distributions.size(); i++) {
+        cout << (i + 1) << ". " << DataGenerator::distributionName(distributions[i]) << endl;
+    }
+    cout << "请选择: ";
+}
+
 // 显示算法选择菜单
 void showAlgorithmMenu() {
     cout << "\n选择排序算法:" << endl;
@@ -84,6 +101,16 @@ void showAlgorithmMenu() {
     cout << "请选择: ";
 }
 
+// 询问随机种子：同一种子生成相同的数据文件
+void askSeed() {
+    uint64_t seed;
+    cout << "随机种子（当前 " << DataGenerator::getSeed() << "，输入 0 保持不变）: ";
+    cin >> seed;
+    if (seed != 0) {
+        DataGenerator::setSeed(seed);
+    }
+}
+
 // 生成测试数据
 void generateTestData() {
     int typeChoice, sizeChoice;
@@ -123,8 +150,31 @@ void generateTestData() {
             return;
     }
 
+    // 整数/浮点数可选输入分布（默认均匀随机）
+    Distribution distribution = Distribution::UNIFORM;
+    if (dataType != "string") {
+        auto distributions = DataGenerator::allDistributions();
+        size_t distributionChoice;
+        showDistributionMenu();
+        cin >> distributionChoice;
+        if (distributionChoice < 1 || distributionChoice > distributions.size()) {
+            cout << "无效选择" << endl;
+            return;
+        }
+        distribution = distributions[distributionChoice - 1];
+    }
+
     // 生成文件名
-    string filename = "data/test_" + dataType + "_" + to_string(dataSize) + ".dat";
+    string filename = Benchmark::inputFilename(dataType, dataSize, distribution);
+
+    if (dataType != "string") {
+        int headerChoice;
+        cout << "写入数据文件头（类型、个数、有序标志等）? (1=是, 0=否): ";
+        cin >> headerChoice;
+        DataGenerator::setWriteHeader(headerChoice == 1);
+    }
+
+    askSeed();
 
     cout << "\n开始生成数据..." << endl;
     cout << "文件: " << filename << endl;
@@ -132,7 +182,10 @@ void generateTestData() {
     cout << "大小: " << dataSize << endl;
 
     try {
-        if (dataType == "int") {
+        if (distribution != Distribution::UNIFORM) {
+            DataGenerator::generateDistributionData(filename, dataSize, distribution,
+                                                    dataType == "int" ? DataType::INTEGER : DataType::DOUBLE);
+        } else if (dataType == "int") {
             DataGenerator::generateIntegerData(filename, dataSize, false);
         } else if (dataType == "double") {
             DataGenerator::generateDoubleData(filename, dataSize, false);
@@ -192,6 +245,8 @@ void generateRealisticData() {
 
     string filename = "data/" + typeStr + "_" + to_string(dataSize) + ".dat";
 
+    askSeed();
+
     cout << "\n开始生成真实数据..." << endl;
 
     try {
@@ -235,6 +290,7 @@ void testSingleAlgorithm() {
     cout << "1. 整数" << endl;
     cout << "2. 浮点数" << endl;
     cout << "3. 字符串" << endl;
+    cout << "4. 指定文件（按数据文件头识别类型）" << endl;
     cout << "0. 返回" << endl;
     cout << "请选择: ";
 
@@ -244,18 +300,43 @@ void testSingleAlgorithm() {
     if (typeChoice == 0) return;
 
     string dataType;
+    string inputFile;
+    int64_t dataSize = 0;
     switch (typeChoice) {
         case 1: dataType = "int"; break;
         case 2: dataType = "double"; break;
         case 3: dataType = "string"; break;
+        case 4: {
+            cout << "\n输入数据文件路径: ";
+            cin >> inputFile;
+            DataFileHeader header;
+            try {
+                if (FileUtils::readDataHeader(inputFile, header)) {
+                    dataType = header.type == ElementType::DOUBLE ? "double" : "int";
+                    dataSize = header.count;
+                } else if (FileUtils::isBinaryStringFile(inputFile)) {
+                    dataType = "string";
+                    dataSize = FileUtils::countStrings(inputFile);
+                }
+            } catch (const exception& e) {
+                cout << "无法识别数据文件: " << e.what() << endl;
+                return;
+            }
+            if (dataType.empty()) {
+                cout << "文件没有数据文件头，请按类型选择" << endl;
+                return;
+            }
+            cout << "识别为 " << dataType << " 数据 (" << dataSize << " 个元素)" << endl;
+            break;
+        }
         default: return;
     }
 
-    cout << "\n输入数据大小: ";
-    int64_t dataSize;
-    cin >> dataSize;
-
-    string inputFile = "data/test_" + dataType + "_" + to_string(dataSize) + ".dat";
+    if (inputFile.empty()) {
+        cout << "\n输入数据大小: ";
+        cin >> dataSize;
+        inputFile = "data/test_" + dataType + "_" + to_string(dataSize) + ".dat";
+    }
     string outputFile = "output/" + algorithm + "_" + dataType + "_" + to_string(dataSize) + ".dat";
 
     // 检查输入文件是否存在
@@ -286,14 +367,15 @@ void testSingleAlgorithm() {
             }
         }
         else if (algorithm == "QuickSort") {
+            string label = QuickSort::BENCHMARK_NAME;
             if (dataType == "int") {
-                result = Benchmark::testFileSortAlgorithm(algorithm, inputFile, outputFile, dataType,
+                result = Benchmark::testFileSortAlgorithm(label, inputFile, outputFile, dataType,
                                                         QuickSort::sortIntegerFile);
             } else if (dataType == "double") {
-                result = Benchmark::testFileSortAlgorithm(algorithm, inputFile, outputFile, dataType,
+                result = Benchmark::testFileSortAlgorithm(label, inputFile, outputFile, dataType,
                                                         QuickSort::sortDoubleFile);
             } else if (dataType == "string") {
-                result = Benchmark::testFileSortAlgorithm(algorithm, inputFile, outputFile, dataType,
+                result = Benchmark::testFileSortAlgorithm(label, inputFile, outputFile, dataType,
                                                         QuickSort::sortStringFile);
             }
         }
@@ -339,6 +421,13 @@ void testSingleAlgorithm() {
         cout << "时间: " << fixed << setprecision(3) << result.timeSeconds << " 秒" << endl;
         cout << "内存: " << Benchmark::formatMemory(result.memoryUsageBytes) << endl;
         cout << "排序验证: " << (result.isSorted ? "成功" : "失败") << endl;
+        if (result.runCount > 0) {
+            cout << "顺串数: " << result.runCount << endl;
+            cout << "生成顺串: " << fixed << setprecision(3) << result.runPhaseSeconds << " 秒" << endl;
+            cout << "归并: " << fixed << setprecision(3) << result.mergePhaseSeconds << " 秒" << endl;
+            cout << "临时写入: " << Benchmark::formatMemory(result.spillBytes)
+                 << " (压缩比 " << fixed << setprecision(2) << result.compressionRatio << ")" << endl;
+        }
 
         cout << "排序结果已保存到: " << outputFile << endl;
 
@@ -420,7 +509,182 @@ void showSystemInfo() {
     cout << "  - 自定义大小" << endl;
 }
 
-int main() {
+// 命令行模式：外排序文件或标准输入/输出（"-"），便于在管道中使用
+void showCommandLineUsage(const char* program) {
+    cerr << "用法: " << program << " --sort <int|double|string> [选项] [输入文件|-] [输出文件|-]" << endl;
+    cerr << "输入文件带数据文件头时可省略 --sort" << endl;
+    cerr << "选项:" << endl;
+    cerr << "  --memory <MB>     内存限制" << endl;
+    cerr << "  --auto-memory     按系统/cgroup 可用内存自动确定预算" << endl;
+    cerr << "  --threads <N>     工作线程数" << endl;
+    cerr << "  --temp <目录>     临时目录（可重复指定）" << endl;
+    cerr << "  --resume          可恢复排序：失败时保留顺串，重新运行时从检查点继续" << endl;
+    cerr << "  --workers <N>     用 N 个本机工作进程分布式排序（仅 int/double 文件）" << endl;
+    cerr << "  --write-block <KB> 输出块大小（默认 1024）" << endl;
+    cerr << "  --io-threads <N>  整块读入/写出数据文件的并行线程数（默认按硬件线程数）" << endl;
+    cerr << "省略文件或使用 - 时读取标准输入、写到标准输出（标准输入须为不带数据文件头的裸数组）" << endl;
+    cerr << "格式转换: " << program << " --convert <bin|text> 输入文件 输出文件" << endl;
+    cerr << "  把每行一个的字符串文本转为二进制字符串格式（bin），或反向转换（text）" << endl;
+}
+
+int runCommandLine(int argc, char* argv[]) {
+    string type;
+    vector<string> paths;
+    vector<string> tempDirs;
+    int workers = 0;
+    string convert;
+
+    try {
+        for (int i = 1; i < argc; i++) {
+            string arg = argv[i];
+            auto value = [&]() -> string {
+                if (i + 1 >= argc) {
+                    throw runtime_error("缺少参数值: " + arg);
+                }
+                return argv[++i];
+            };
+
+            if (arg == "--sort") {
+                type = value();
+            } else if (arg == "--memory") {
+                ExternalSort::setMemoryLimit(stoull(value()) * 1024 * 1024);
+            } else if (arg == "--auto-memory") {
+                ExternalSort::setAutoMemory(true);
+            } else if (arg == "--threads") {
+                ExternalSort::setThreadCount(stoi(value()));
+            } else if (arg == "--temp") {
+                tempDirs.push_back(value());
+            } else if (arg == "--resume") {
+                ExternalSort::setResumable(true);
+            } else if (arg == "--workers") {
+                workers = stoi(value());
+            } else if (arg == "--write-block") {
+                FileUtils::setWriteBlockSize(stoull(value()) * 1024);
+            } else if (arg == "--io-threads") {
+                unsigned threads = stoul(value());
+                FileUtils::setReadThreads(threads);
+                FileUtils::setWriteThreads(threads);
+            } else if (arg == "--convert") {
+                convert = value();
+            } else if (arg == "-" || arg[0] != '-') {
+                paths.push_back(arg);
+            } else {
+                throw runtime_error("未知参数: " + arg);
+            }
+        }
+        // 未指定 --sort 时按输入文件的数据文件头（或二进制字符串格式）识别类型
+        DataFileHeader header;
+        if (type.empty() && convert.empty() && !paths.empty() && paths[0] != "-") {
+            if (FileUtils::readDataHeader(paths[0], header)) {
+                type = header.type == ElementType::DOUBLE ? "double" : "int";
+            } else if (FileUtils::isBinaryStringFile(paths[0])) {
+                type = "string";
+            }
+        }
+        if (!convert.empty()) {
+            if ((convert != "bin" && convert != "text") || paths.size() != 2) {
+                throw runtime_error("参数错误");
+            }
+        } else if ((type != "int" && type != "double" && type != "string") || paths.size() > 2) {
+            throw runtime_error("参数错误");
+        }
+        if (workers > 0 && (type == "string" || paths.size() != 2 || paths[0] == "-" || paths[1] == "-")) {
+            throw runtime_error("--workers 只支持整数/浮点数文件");
+        }
+    } catch (const exception& e) {
+        cerr << "错误: " << e.what() << endl;
+        showCommandLineUsage(argv[0]);
+        return 2;
+    }
+
+    if (!tempDirs.empty()) {
+        ExternalSort::setTempDirectories(tempDirs);
+    }
+
+    string inputFile = paths.size() > 0 ? paths[0] : "-";
+    string outputFile = paths.size() > 1 ? paths[1] : "-";
+
+    try {
+        if (!convert.empty()) {
+            if (convert == "bin") {
+                FileUtils::textToBinaryStrings(inputFile, outputFile);
+            } else {
+                FileUtils::binaryToTextStrings(inputFile, outputFile);
+            }
+            cout << "转换完成: " << outputFile << " (" << FileUtils::countStrings(outputFile) << " 个字符串)" << endl;
+            return 0;
+        }
+
+        if (workers > 0) {
+            if (type == "int") {
+                DistributedSort::sortIntegerFile(inputFile, outputFile, workers);
+            } else {
+                DistributedSort::sortDoubleFile(inputFile, outputFile, workers);
+            }
+            DistributedSort::printStats();
+            return 0;
+        }
+
+        if (inputFile != "-" && outputFile != "-") {
+            if (type == "int") {
+                ExternalSort::sortIntegerFile(inputFile, outputFile);
+            } else if (type == "double") {
+                ExternalSort::sortDoubleFile(inputFile, outputFile);
+            } else {
+                ExternalSort::sortStringFile(inputFile, outputFile);
+            }
+            return 0;
+        }
+
+        ios::sync_with_stdio(false);
+#ifdef _WIN32
+        _setmode(_fileno(stdin), _O_BINARY);
+        _setmode(_fileno(stdout), _O_BINARY);
+#endif
+
+        ifstream inFile;
+        ofstream outFile;
+        if (inputFile != "-") {
+            inFile.open(inputFile, ios::binary);
+            if (!inFile) {
+                throw runtime_error("无法打开输入文件: " + inputFile);
+            }
+            // 流式排序只处理裸数组：跳过数据文件头（其类型须与 --sort 一致）
+            DataFileHeader inputHeader;
+            if (type != "string" &&
+                FileUtils::readDataHeader(inputFile, inputHeader,
+                                          type == "double" ? ElementType::DOUBLE : ElementType::INT64)) {
+                inFile.seekg(sizeof(DataFileHeader));
+            }
+        }
+        if (outputFile != "-") {
+            outFile.open(outputFile, ios::binary);
+            if (!outFile) {
+                throw runtime_error("无法打开输出文件: " + outputFile);
+            }
+        }
+        istream& in = inputFile != "-" ? static_cast<istream&>(inFile) : cin;
+        ostream& out = outputFile != "-" ? static_cast<ostream&>(outFile) : cout;
+
+        if (type == "int") {
+            ExternalSort::sortIntegerStream(in, out);
+        } else if (type == "double") {
+            ExternalSort::sortDoubleStream(in, out);
+        } else {
+            ExternalSort::sortStringStream(in, out);
+        }
+    } catch (const exception& e) {
+        cerr << "排序失败: " << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1) {
+        return runCommandLine(argc, argv);
+    }
+
     cout << "排序算法性能测试系统 v1.0" << endl;
     cout << "==========================" << endl;
 
@@ -468,6 +732,30 @@ int main() {
             case 8:
                 showSystemInfo();
                 break;
+            case 9:
+                {
+                    // 各种输入分布下的算法表现（整数/浮点数）
+                    int sizeChoice;
+                    showDataSizeMenu();
+                    cin >> sizeChoice;
+                    int64_t dataSize = 0;
+                    switch (sizeChoice) {
+                        case 1: dataSize = 1000000; break;
+                        case 2: dataSize = 10000000; break;
+                        case 3: dataSize = 100000000; break;
+                        case 4:
+                            cout << "输入数据大小: ";
+                            cin >> dataSize;
+                            break;
+                        default: break;
+                    }
+                    if (dataSize > 0) {
+                        auto results = Benchmark::runDistributionTests(dataSize);
+                        Benchmark::generateReport(results);
+                        Benchmark::generateCSVReport(results, "reports/distribution_results.csv");
+                    }
+                }
+                break;
             case 0:
                 cout << "\n退出系统，再见！" << endl;
                 break;
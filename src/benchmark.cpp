@@ -17,11 +17,33 @@
 using namespace std;
 using namespace chrono;
 
+namespace {
+
+// 外排序测试期间打开写出校验，离开作用域（含异常）时恢复原设置
+class VerifyOutputScope {
+public:
+    explicit VerifyOutputScope(bool enable) : previous(ExternalSort::getVerifyOutput()) {
+        if (enable) {
+            ExternalSort::setVerifyOutput(true);
+        }
+    }
+    ~VerifyOutputScope() { ExternalSort::setVerifyOutput(previous); }
+
+    VerifyOutputScope(const VerifyOutputScope&) = delete;
+    VerifyOutputScope& operator=(const VerifyOutputScope&) = delete;
+
+private:
+    bool previous;
+};
+
+}
+
 // 性能结果转为字符串
 string PerformanceResult::toString() const {
     stringstream ss;
     ss << "算法: " << algorithmName
        << ", 类型: " << dataType
+       << ", 分布: " << distribution
        << ", 大小: " << dataSize
        << ", 时间: " << fixed << setprecision(6) << timeSeconds << "秒"
        << ", 内存: " << Benchmark::formatMemory(memoryUsageBytes)
@@ -45,6 +67,9 @@ PerformanceResult Benchmark::testInMemoryAlgorithm(
     result.dataType = dataType;
 
     try {
+        // 外排序在读入/写出时顺带校验，省去重读输出
+        VerifyOutputScope verifyScope(algorithmName.rfind("ExternalSort", 0) == 0);
+
         // 开始监控
         MemoryMonitor::start();
         auto startTime = high_resolution_clock::now();
@@ -113,18 +138,27 @@ PerformanceResult Benchmark::testFileSortAlgorithm(
         size_t fileSize = inFile.tellg();
         inFile.close();
 
-        // 根据数据类型计算元素数量
-        if (dataType == "int") {
+        // 根据数据类型计算元素数量（带数据文件头时直接取文件头中的个数）
+        DataFileHeader inputHeader;
+        bool headered = dataType != "string" && FileUtils::readDataHeader(inputFile, inputHeader);
+        if (headered) {
+            result.dataSize = inputHeader.count;
+        } else if (dataType == "int") {
             result.dataSize = fileSize / sizeof(int64_t);
         } else if (dataType == "double") {
             result.dataSize = fileSize / sizeof(double);
         } else if (dataType == "string") {
-            // 对于字符串，需要实际读取来计数
-            vector<string> data = DataGenerator::readStringData(inputFile);
-            result.dataSize = data.size();
+            // 对于字符串，二进制格式读文件头，文本格式按行切分计数
+            result.dataSize = FileUtils::countStrings(inputFile);
         }
 
+        // 外排序在读入/写出时顺带校验，省去重读输出
+        bool externalSort = algorithmName.rfind("ExternalSort", 0) == 0;
+        VerifyOutputScope verifyScope(externalSort);
+
         // 开始监控
+        DataGenerator::resetLoadSeconds();
+        FileUtils::resetWriteStats();
         MemoryMonitor::start();
         auto startTime = high_resolution_clock::now();
 
@@ -133,6 +167,9 @@ PerformanceResult Benchmark::testFileSortAlgorithm(
 
         auto endTime = high_resolution_clock::now();
         MemoryMonitor::stop();
+        result.loadSeconds = DataGenerator::getLoadSeconds();
+        result.writeBytes = FileUtils::getWriteBytes();
+        result.writeSeconds = FileUtils::getWriteSeconds();
 
         // 计算时间
         auto duration = duration_cast<nanoseconds>(endTime - startTime);
@@ -142,8 +179,29 @@ PerformanceResult Benchmark::testFileSortAlgorithm(
         result.memoryUsageBytes = MemoryMonitor::getPeakUsage();
         result.peakMemoryBytes = result.memoryUsageBytes;
 
+        // 外排序的顺串数与分阶段耗时
+        bool verified = false;
+        if (externalSort) {
+            const ExternalSortStats& stats = ExternalSort::getLastStats();
+            result.runCount = stats.runCount;
+            result.runPhaseSeconds = stats.runPhaseSeconds;
+            result.mergePhaseSeconds = stats.mergePhaseSeconds;
+            result.spillBytes = stats.spillBytes;
+            if (stats.spillBytes > 0) {
+                result.compressionRatio = static_cast<double>(stats.rawSpillBytes) / stats.spillBytes;
+            }
+
+            // 有序且与输入的多重集合哈希一致
+            if (stats.verified) {
+                result.isSorted = stats.outputValid();
+                verified = true;
+            }
+        }
+
         // 验证排序结果
-        if (dataType == "int") {
+        if (verified) {
+            // 已在写出时校验
+        } else if (dataType == "int") {
             result.isSorted = DataGenerator::verifyIntegerSorted(outputFile);
         } else if (dataType == "double") {
             result.isSorted = DataGenerator::verifyDoubleSorted(outputFile);
@@ -151,6 +209,14 @@ PerformanceResult Benchmark::testFileSortAlgorithm(
             result.isSorted = DataGenerator::verifyStringSorted(outputFile);
         }
 
+        // 输入输出都带文件头时，与顺序无关的校验和应当相同（发现丢失或重复的元素）
+        DataFileHeader outputHeader;
+        if (headered && FileUtils::readDataHeader(outputFile, outputHeader) &&
+            (outputHeader.count != inputHeader.count || outputHeader.checksum != inputHeader.checksum)) {
+            cerr << "输出与输入的元素不一致: " << outputFile << endl;
+            result.isSorted = false;
+        }
+
     } catch (const exception& e) {
         cerr << "文件排序测试失败 (" << algorithmName << "): " << e.what() << endl;
         result.isSorted = false;
@@ -159,14 +225,25 @@ PerformanceResult Benchmark::testFileSortAlgorithm(
     return result;
 }
 
+// 按算法名后缀配置外排序变体
+void Benchmark::applyExternalSortVariant(const string& algorithm) {
+    bool codec = algorithm.find("-Codec") != string::npos;
+    bool mmap = algorithm.find("-Mmap") != string::npos;
+    bool direct = algorithm.find("-Direct") != string::npos;
+    ExternalSort::setRunCodec(codec ? RunCodecType::DELTA_VARINT : RunCodecType::NONE);
+    ExternalSort::setInputMode(mmap ? InputReadMode::MMAP : InputReadMode::STREAM);
+    ExternalSort::setDirectIO(direct);
+}
+
 // 运行单个测试用例 - 修复函数签名
 PerformanceResult Benchmark::runTest(const string& algorithm,
                                     const string& dataType,
-                                    int64_t size) {
+                                    int64_t size,
+                                    Distribution distribution) {
 
     // 生成输入输出文件名
-    string inputFile = "data/test_" + dataType + "_" + to_string(size) + ".dat";
-    string outputFile = "output/" + algorithm + "_" + dataType + "_" + to_string(size) + ".dat";
+    string inputFile = inputFilename(dataType, size, distribution);
+    string outputFile = "output/" + algorithm + "_" + inputFile.substr(inputFile.find("test_") + 5);
 
     // 检查输入文件是否存在
     ifstream testFile(inputFile);
@@ -176,7 +253,9 @@ PerformanceResult Benchmark::runTest(const string& algorithm,
     }
     testFile.close();
 
-    cout << "运行测试: " << algorithm << " on " << dataType << " (" << size << ")" << endl;
+    const char* distributionName = DataGenerator::distributionName(distribution);
+    cout << "运行测试: " << algorithm << " on " << dataType << " (" << size << ", "
+         << distributionName << ")" << endl;
 
     PerformanceResult result;
 
@@ -194,14 +273,15 @@ PerformanceResult Benchmark::runTest(const string& algorithm,
             }
         }
         else if (algorithm == "QuickSort") {
+            string label = QuickSort::BENCHMARK_NAME;
             if (dataType == "int") {
-                result = testFileSortAlgorithm(algorithm, inputFile, outputFile, dataType,
+                result = testFileSortAlgorithm(label, inputFile, outputFile, dataType,
                                              QuickSort::sortIntegerFile);
             } else if (dataType == "double") {
-                result = testFileSortAlgorithm(algorithm, inputFile, outputFile, dataType,
+                result = testFileSortAlgorithm(label, inputFile, outputFile, dataType,
                                              QuickSort::sortDoubleFile);
             } else if (dataType == "string") {
-                result = testFileSortAlgorithm(algorithm, inputFile, outputFile, dataType,
+                result = testFileSortAlgorithm(label, inputFile, outputFile, dataType,
                                              QuickSort::sortStringFile);
             }
         }
@@ -226,7 +306,9 @@ PerformanceResult Benchmark::runTest(const string& algorithm,
                                              RadixSort::sortStringFile);
             }
         }
-        else if (algorithm == "ExternalSort") {
+        else if (algorithm.rfind("ExternalSort", 0) == 0) {
+            applyExternalSortVariant(algorithm);
+
             if (dataType == "int") {
                 result = testFileSortAlgorithm(algorithm, inputFile, outputFile, dataType,
                                              ExternalSort::sortIntegerFile);
@@ -237,12 +319,15 @@ PerformanceResult Benchmark::runTest(const string& algorithm,
                 result = testFileSortAlgorithm(algorithm, inputFile, outputFile, dataType,
                                              ExternalSort::sortStringFile);
             }
+
+            applyExternalSortVariant("ExternalSort");
         }
 
     } catch (const exception& e) {
         cerr << "测试异常: " << e.what() << endl;
     }
 
+    result.distribution = distributionName;
     return result;
 }
 
@@ -253,7 +338,8 @@ vector<PerformanceResult> Benchmark::runAllTests() {
     vector<PerformanceResult> allResults;
 
     // 测试配置
-    vector<string> algorithms = {"ShellSort", "QuickSort", "MergeSort", "RadixSort", "ExternalSort"};
+    vector<string> algorithms = {"ShellSort", "QuickSort", "MergeSort", "RadixSort", "ExternalSort",
+                                 "ExternalSort-Codec", "ExternalSort-Mmap", "ExternalSort-Direct"};
     vector<string> dataTypes = {"int", "double", "string"};
     vector<int64_t> sizes = {1000000, 10000000}; // 先测试较小的规模
 
@@ -261,6 +347,8 @@ vector<PerformanceResult> Benchmark::runAllTests() {
         for (const string& type : dataTypes) {
             // RadixSort不支持double类型
             if (algo == "RadixSort" && type == "double") continue;
+            // 顺串编码、映射输入与直接 I/O 只作用于整数/浮点数
+            if (algo.rfind("ExternalSort-", 0) == 0 && type == "string") continue;
 
             for (int64_t size : sizes) {
                 PerformanceResult result = runTest(algo, type, size); // 这里修改
@@ -275,6 +363,48 @@ vector<PerformanceResult> Benchmark::runAllTests() {
     return allResults;
 }
 
+string Benchmark::inputFilename(const string& dataType, int64_t size, Distribution distribution) {
+    string prefix = "data/test_";
+    if (distribution != Distribution::UNIFORM) {
+        prefix += string(DataGenerator::distributionName(distribution)) + "_";
+    }
+    return prefix + dataType + "_" + to_string(size) + ".dat";
+}
+
+// 按输入分布扫描
+vector<PerformanceResult> Benchmark::runDistributionTests(int64_t size, const vector<Distribution>& distributions) {
+    cout << "\n开始运行输入分布测试..." << endl;
+
+    vector<PerformanceResult> allResults;
+
+    vector<string> algorithms = {"ShellSort", "QuickSort", "MergeSort", "RadixSort", "ExternalSort"};
+    vector<string> dataTypes = {"int", "double"};
+
+    for (Distribution distribution : distributions) {
+        for (const string& type : dataTypes) {
+            // 输入按种子确定性生成，缺失时补上即可复现
+            string inputFile = inputFilename(type, size, distribution);
+            if (FileUtils::getFileSize(inputFile) < 0) {
+                DataGenerator::generateDistributionData(inputFile, size, distribution,
+                                                        type == "int" ? DataType::INTEGER : DataType::DOUBLE);
+            }
+
+            for (const string& algo : algorithms) {
+                // RadixSort不支持double类型
+                if (algo == "RadixSort" && type == "double") continue;
+
+                PerformanceResult result = runTest(algo, type, size, distribution);
+                if (result.dataSize > 0) {
+                    allResults.push_back(result);
+                }
+            }
+        }
+    }
+
+    cout << "\n输入分布测试完成!" << endl;
+    return allResults;
+}
+
 // 生成测试报告
 void Benchmark::generateReport(const vector<PerformanceResult>& results) {
     cout << "\n" << string(120, '=') << endl;
@@ -284,31 +414,65 @@ void Benchmark::generateReport(const vector<PerformanceResult>& results) {
     // 按算法和数据大小分组
     map<string, vector<PerformanceResult>> groupedResults;
     for (const auto& result : results) {
-        string key = result.algorithmName + "_" + result.dataType;
+        string key = result.algorithmName + "_" + result.dataType + "_" + result.distribution;
         groupedResults[key].push_back(result);
     }
 
     cout << setw(20) << left << "算法"
          << setw(10) << right << "类型"
+         << setw(16) << right << "分布"
          << setw(15) << right << "数据规模"
          << setw(15) << right << "时间(秒)"
+         << setw(15) << right << "加载(秒)"
+         << setw(15) << right << "写出(MB/s)"
          << setw(20) << right << "内存使用"
          << setw(20) << right << "峰值内存"
          << setw(10) << right << "验证" << endl;
-    cout << string(120, '-') << endl;
+    cout << string(156, '-') << endl;
 
     for (const auto& [key, algoResults] : groupedResults) {
         for (const auto& result : algoResults) {
             cout << setw(20) << left << result.algorithmName
                  << setw(10) << right << result.dataType
+                 << setw(16) << right << result.distribution
                  << setw(15) << right << result.dataSize
                  << setw(15) << right << fixed << setprecision(6) << result.timeSeconds
+                 << setw(15) << right << fixed << setprecision(6) << result.loadSeconds
+                 << setw(15) << right << fixed << setprecision(1) << result.writeMBps()
                  << setw(20) << right << formatMemory(result.memoryUsageBytes)
                  << setw(20) << right << formatMemory(result.peakMemoryBytes)
                  << setw(10) << right << (result.isSorted ? "是" : "否") << endl;
         }
     }
 
+    // 外排序阶段统计
+    bool hasPhaseStats = false;
+    for (const auto& result : results) {
+        if (result.runCount > 0) {
+            if (!hasPhaseStats) {
+                cout << "\n外排序阶段统计" << endl;
+                cout << string(120, '-') << endl;
+                cout << setw(20) << left << "算法"
+                     << setw(10) << right << "类型"
+                     << setw(15) << right << "数据规模"
+                     << setw(15) << right << "顺串数"
+                     << setw(20) << right << "生成顺串(秒)"
+                     << setw(20) << right << "归并(秒)"
+                     << setw(20) << right << "临时写入"
+                     << setw(10) << right << "压缩比" << endl;
+                hasPhaseStats = true;
+            }
+            cout << setw(20) << left << result.algorithmName
+                 << setw(10) << right << result.dataType
+                 << setw(15) << right << result.dataSize
+                 << setw(15) << right << result.runCount
+                 << setw(20) << right << fixed << setprecision(6) << result.runPhaseSeconds
+                 << setw(20) << right << fixed << setprecision(6) << result.mergePhaseSeconds
+                 << setw(20) << right << formatMemory(result.spillBytes)
+                 << setw(10) << right << fixed << setprecision(2) << result.compressionRatio << endl;
+        }
+    }
+
     // 性能总结
     cout << "\n" << string(120, '=') << endl;
     cout << "性能总结" << endl;
@@ -367,7 +531,9 @@ void Benchmark::generateCSVReport(const vector<PerformanceResult>& results,
     }
 
     // 写入CSV头部
-    csvFile << "Algorithm,DataType,DataSize,TimeSeconds,MemoryUsageBytes,PeakMemoryBytes,IsSorted" << endl;
+    csvFile << "Algorithm,DataType,DataSize,TimeSeconds,MemoryUsageBytes,PeakMemoryBytes,IsSorted,"
+            << "RunCount,RunPhaseSeconds,MergePhaseSeconds,SpillBytes,CompressionRatio,LoadSeconds,"
+            << "WriteBytes,WriteSeconds,WriteMBps,Distribution" << endl;
 
     // 写入数据
     for (const auto& result : results) {
@@ -377,7 +543,17 @@ void Benchmark::generateCSVReport(const vector<PerformanceResult>& results,
                 << fixed << setprecision(6) << result.timeSeconds << ","
                 << result.memoryUsageBytes << ","
                 << result.peakMemoryBytes << ","
-                << (result.isSorted ? "true" : "false") << endl;
+                << (result.isSorted ? "true" : "false") << ","
+                << result.runCount << ","
+                << result.runPhaseSeconds << ","
+                << result.mergePhaseSeconds << ","
+                << result.spillBytes << ","
+                << result.compressionRatio << ","
+                << result.loadSeconds << ","
+                << result.writeBytes << ","
+                << result.writeSeconds << ","
+                << result.writeMBps() << ","
+                << result.distribution << endl;
     }
 
     csvFile.close();
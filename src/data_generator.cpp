@@ -8,235 +8,527 @@
 #include <iomanip>
 #include <chrono>
 #include <cfloat>
+#include <climits>
+#include <cstdio>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <exception>
 
 using namespace std;
 
-// DataGenerator 实现
-int64_t DataGenerator::getSizeValue(DataSize size) {
-    switch (size) {
-        case DataSize::SIZE_1M:   return 1000000;
-        case DataSize::SIZE_10M:  return 10000000;
-        case DataSize::SIZE_100M: return 100000000;
-        case DataSize::SIZE_500M: return 500000000;
-        case DataSize::SIZE_1G:   return 1000000000;
-        default: return 1000000;
-    }
-}
+double DataGenerator::loadSeconds = 0;
+bool DataGenerator::writeHeader = false;
+uint64_t DataGenerator::seed = 42;
+unsigned DataGenerator::threadCount = 0;
+DistributionOptions DataGenerator::distributionOptions;
+
+namespace {
 
-std::mt19937_64& DataGenerator::getRandomEngine() {
-    static thread_local std::mt19937_64 engine(
-        chrono::steady_clock::now().time_since_epoch().count()
-    );
-    return engine;
+// 自 start 起经过的秒数
+double secondsSince(chrono::steady_clock::time_point start) {
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
 }
 
-void DataGenerator::generateIntegerData(const std::string& filename,
-                                        int64_t size,
-                                        bool allowDuplicates) {
+// 文件头记录的个数、最小/最大值与校验和是否与数据一致（有序标志不要求
+// 一致：未标记有序的文件内容仍可能有序）
+bool headerMatches(const DataFileHeader& recorded, const DataFileHeader& actual) {
+    return recorded.count == actual.count && recorded.minBits == actual.minBits &&
+           recorded.maxBits == actual.maxBits && recorded.checksum == actual.checksum &&
+           (!recorded.sorted() || actual.sorted());
+}
 
-    ofstream outFile(filename, ios::binary);
-    if (!outFile) {
-        throw runtime_error("无法打开文件：" + filename);
+// 各生成器的随机数流号：同一种子下不同种类的数据互不相关
+enum GeneratorStream : uint64_t {
+    STREAM_INTEGER = 1,
+    STREAM_UNIQUE_INTEGER,
+    STREAM_DOUBLE,
+    STREAM_STRING,
+    STREAM_REALISTIC_INTEGER,
+    STREAM_REALISTIC_DOUBLE,
+    STREAM_REALISTIC_STRING,
+    STREAM_DISTRIBUTION = 16        // 加上 Distribution 的序号
+};
+
+// 每块的元素/行数。块是随机数流的单位，必须与线程数无关，同一种子才能
+// 生成相同的文件
+const int64_t GENERATE_BLOCK = 1 << 20;
+const int64_t STRING_BLOCK = 1 << 16;
+
+// 在 threads 个线程上运行 work(线程号)，任一线程的异常在全部结束后重新抛出
+void runWorkers(unsigned threads, const function<void(unsigned)>& work) {
+    vector<exception_ptr> errors(threads);
+    auto guarded = [&](unsigned index) {
+        try {
+            work(index);
+        } catch (...) {
+            errors[index] = current_exception();
+        }
+    };
+    vector<thread> workers;
+    for (unsigned index = 1; index < threads; index++) {
+        workers.emplace_back(guarded, index);
+    }
+    guarded(0);
+    for (auto& worker : workers) worker.join();
+    for (auto& error : errors) {
+        if (error) rethrow_exception(error);
     }
+}
 
-    const int64_t BATCH_SIZE = 1000000;  // 每批100万个
-    auto& engine = getRandomEngine();
+unsigned generateThreads(int64_t blocks) {
+    unsigned threads = DataGenerator::getThreadCount();
+    if (threads == 0) {
+        threads = max(1u, thread::hardware_concurrency());
+    }
+    return static_cast<unsigned>(max<int64_t>(1, min<int64_t>(threads, blocks)));
+}
 
-    if (allowDuplicates) {
-        // 允许重复的随机数
-        uniform_int_distribution<int64_t> dist(-1000000000, 1000000000);
+// 按完成的块数输出进度（每 10 块一次，各线程共用）
+class GenerateProgress {
+public:
+    GenerateProgress(const string& label, int64_t blocks) : label(label), blocks(blocks) {}
 
-        for (int64_t i = 0; i < size; i += BATCH_SIZE) {
-            int64_t batchSize = min(BATCH_SIZE, size - i);
-            vector<int64_t> batch(batchSize);
+    void blockDone() {
+        int64_t done = ++completed;
+        if (done % 10 == 0 && done < blocks) {
+            lock_guard<mutex> lock(outputMutex);
+            cout << label << "进度: " << (done * 100.0 / blocks) << "%" << endl;
+        }
+    }
 
-            for (int64_t j = 0; j < batchSize; j++) {
-                batch[j] = dist(engine);
+private:
+    string label;
+    int64_t blocks;
+    atomic<int64_t> completed{0};
+    mutex outputMutex;
+};
+
+// 并行生成定长元素的数据文件：各线程领取块号，fill(rng, first, out, n) 生成
+// 下标 first 起的 n 个元素，按块号算出的偏移直接写入文件；带文件头时各块
+// 分别统计，最后按块序合并
+template<typename T, typename Fill>
+void generateFixed(const string& filename, int64_t size, uint64_t stream, const string& label, Fill fill) {
+    bool withHeader = DataGenerator::getWriteHeader();
+    uint64_t headerBytes = withHeader ? sizeof(DataFileHeader) : 0;
+    int64_t blocks = (size + GENERATE_BLOCK - 1) / GENERATE_BLOCK;
+
+    OutputFile file(filename);
+    file.truncate(headerBytes + size * sizeof(T));
+    vector<DataHeaderBuilder<T>> builders(withHeader ? blocks : 0);
+    atomic<int64_t> nextBlock{0};
+    GenerateProgress progress(label, blocks);
+
+    runWorkers(generateThreads(blocks), [&](unsigned) {
+        vector<T> buffer;
+        for (int64_t block = nextBlock++; block < blocks; block = nextBlock++) {
+            int64_t first = block * GENERATE_BLOCK;
+            size_t n = min(GENERATE_BLOCK, size - first);
+            buffer.resize(n);
+            CounterRng rng(DataGenerator::getSeed(), stream, block);
+            fill(rng, first, buffer.data(), n);
+            if (withHeader) {
+                builders[block].add(buffer.data(), n);
             }
+            file.writeAt(buffer.data(), n * sizeof(T), headerBytes + first * sizeof(T));
+            progress.blockDone();
+        }
+    });
 
-            outFile.write(reinterpret_cast<const char*>(batch.data()),
-                         batchSize * sizeof(int64_t));
+    if (withHeader) {
+        DataHeaderBuilder<T> total;
+        for (const auto& builder : builders) {
+            total.merge(builder);
+        }
+        DataFileHeader header = total.header();
+        file.writeAt(&header, sizeof(header), 0);
+    }
+    file.close();
+}
 
-            if (i > 0 && i % (10 * BATCH_SIZE) == 0) {
-                cout << "生成整数数据进度: " << (i * 100.0 / size) << "%" << endl;
-            }
+// 并行生成文本数据：每一轮各线程把一块的各行生成到自己的缓冲区
+// （fill(rng, first, n, out) 追加下标 first 起的 n 行），再按块序接着写出
+template<typename Fill>
+void generateLines(const string& filename, int64_t size, uint64_t stream, const string& label, Fill fill) {
+    int64_t blocks = (size + STRING_BLOCK - 1) / STRING_BLOCK;
+    unsigned threads = generateThreads(blocks);
+
+    OutputFile file(filename);
+    vector<string> buffers(threads);
+    uint64_t offset = 0;
+    GenerateProgress progress(label, blocks);
+
+    for (int64_t round = 0; round < blocks; round += threads) {
+        unsigned active = static_cast<unsigned>(min<int64_t>(threads, blocks - round));
+        runWorkers(active, [&](unsigned index) {
+            int64_t block = round + index;
+            int64_t first = block * STRING_BLOCK;
+            buffers[index].clear();
+            CounterRng rng(DataGenerator::getSeed(), stream, block);
+            fill(rng, first, min(STRING_BLOCK, size - first), buffers[index]);
+            progress.blockDone();
+        });
+        for (unsigned index = 0; index < active; index++) {
+            file.writeAt(buffers[index].data(), buffers[index].size(), offset);
+            offset += buffers[index].size();
         }
-    } else {
-        // 生成不重复的随机数（使用哈希）
-        for (int64_t i = 0; i < size; i += BATCH_SIZE) {
-            int64_t batchSize = min(BATCH_SIZE, size - i);
-            vector<int64_t> batch(batchSize);
-
-            // 使用哈希函数生成伪随机但唯一的数字
-            for (int64_t j = 0; j < batchSize; j++) {
-                int64_t index = i + j;
-                // 使用乘法哈希
-                const int64_t multiplier = 6364136223846793005ULL;
-                const int64_t increment = 1442695040888963407ULL;
-                batch[j] = index * multiplier + increment;
-            }
+    }
+    file.close();
+}
 
-            // 打乱批次内顺序
-            shuffle(batch.begin(), batch.end(), engine);
+// Musser 的 median-of-3 killer 序列的第 i 个元素：长度取到 4 的倍数 m，
+// 前半段为 1, k+1, 3, k+3, ...，后半段为 2, 4, ..., 2k（k = m/2），多出的尾部递增
+int64_t median3Killer(int64_t i, int64_t size) {
+    int64_t m = size - size % 4;
+    if (i >= m) return i + 1;
+    int64_t k = m / 2;
+    if (i < k) return i % 2 == 0 ? i + 1 : k + i;
+    return 2 * (i - k + 1);
+}
 
-            outFile.write(reinterpret_cast<const char*>(batch.data()),
-                         batchSize * sizeof(int64_t));
+// NEARLY_SORTED 的交换：Feistel 置换把全部位置随机两两配对（置换后的 2k 与 2k+1），
+// 每对以 percent% 的概率交换。任一位置换来的元素可以单独求出，交换跨越整个文件，
+// 各块仍可独立生成
+class SwapPairs {
+public:
+    SwapPairs(int64_t size, double percent, uint64_t key)
+        : size(size), probability(percent / 100.0), pairing(size, key), selectKey(CounterRng::mix(~key)) {}
+
+    // 位置 i 上的元素原来所在的位置
+    int64_t source(int64_t i) const {
+        uint64_t slot = pairing(i);
+        uint64_t mate = slot ^ 1;
+        if (mate >= static_cast<uint64_t>(size)) return i;
+        double draw = (CounterRng::mix(selectKey + slot / 2) >> 11) * (1.0 / 9007199254740992.0);
+        return draw < probability ? static_cast<int64_t>(pairing.inverse(mate)) : i;
+    }
 
-            if (i > 0 && i % (10 * BATCH_SIZE) == 0) {
-                cout << "生成整数数据进度: " << (i * 100.0 / size) << "%" << endl;
-            }
+private:
+    int64_t size;
+    double probability;
+    FeistelPermutation pairing;
+    uint64_t selectKey;
+};
+
+// 按结构化分布填充下标 first 起的 n 个元素（共 size 个）；随机取值用本块的 rng
+template<typename T>
+void fillDistribution(Distribution distribution, const DistributionOptions& options,
+                      const vector<double>& zipfCdf, const SwapPairs& swaps, CounterRng& rng,
+                      int64_t first, int64_t size, T* out, size_t n) {
+    int64_t runLength = max<int64_t>(1, (size + options.runCount - 1) / options.runCount);
+    for (size_t j = 0; j < n; j++) {
+        int64_t i = first + j;
+        int64_t value = 0;
+        switch (distribution) {
+            case Distribution::UNIFORM:
+                value = static_cast<int64_t>(rng.below(2000000001)) - 1000000000;
+                break;
+            case Distribution::SORTED:
+                value = i;
+                break;
+            case Distribution::NEARLY_SORTED:
+                value = swaps.source(i);
+                break;
+            case Distribution::REVERSE_SORTED:
+                value = size - 1 - i;
+                break;
+            case Distribution::ORGAN_PIPE:
+                value = i < (size + 1) / 2 ? i : size - 1 - i;
+                break;
+            case Distribution::SAWTOOTH:
+                value = i % runLength;
+                break;
+            case Distribution::FEW_UNIQUE:
+                value = rng.below(options.uniqueValues);
+                break;
+            case Distribution::ALL_EQUAL:
+                value = 0;
+                break;
+            case Distribution::ZIPF:
+                value = min<int64_t>(upper_bound(zipfCdf.begin(), zipfCdf.end(), rng.unit()) - zipfCdf.begin(),
+                                     zipfCdf.size() - 1);
+                break;
+            case Distribution::SORTED_RUNS:
+                // 第 i / runLength 个顺串的第 i % runLength 个元素
+                value = (i % runLength) * options.runCount + i / runLength;
+                break;
+            case Distribution::MEDIAN3_KILLER:
+                value = median3Killer(i, size);
+                break;
         }
+        out[j] = static_cast<T>(value);
     }
-
-    outFile.close();
-    cout << "整数数据生成完成: " << filename << " (大小: " << size << ")" << endl;
 }
 
-void DataGenerator::generateDoubleData(const std::string& filename,
-                                       int64_t size,
-                                       bool allowDuplicates) {
+} // namespace
 
-    ofstream outFile(filename, ios::binary);
-    if (!outFile) {
-        throw runtime_error("无法打开文件: " + filename);
+// DataGenerator 实现
+int64_t DataGenerator::getSizeValue(DataSize size) {
+    switch (size) {
+        case DataSize::SIZE_1M:   return 1000000;
+        case DataSize::SIZE_10M:  return 10000000;
+        case DataSize::SIZE_100M: return 100000000;
+        case DataSize::SIZE_500M: return 500000000;
+        case DataSize::SIZE_1G:   return 1000000000;
+        default: return 1000000;
     }
+}
 
-    const int64_t BATCH_SIZE = 1000000;
-    auto& engine = getRandomEngine();
-    uniform_real_distribution<double> dist(-1000000.0, 1000000.0);
+void DataGenerator::generateIntegerData(const std::string& filename,
+                                        int64_t size,
+                                        bool allowDuplicates) {
 
-    for (int64_t i = 0; i < size; i += BATCH_SIZE) {
-        int64_t batchSize = min(BATCH_SIZE, size - i);
-        vector<double> batch(batchSize);
+    if (allowDuplicates) {
+        // 允许重复的随机数，均匀分布在 [-1e9, 1e9]
+        generateFixed<int64_t>(filename, size, STREAM_INTEGER, "生成整数数据",
+            [](CounterRng& rng, int64_t, int64_t* out, size_t n) {
+                for (size_t j = 0; j < n; j++) {
+                    out[j] = static_cast<int64_t>(rng.below(2000000001)) - 1000000000;
+                }
+            });
+    } else {
+        // 生成不重复的随机数：下标先经 Feistel 置换打乱到 [0, size) 中的随机位置，
+        // 再用乘法哈希散布到整个 64 位范围（模 2^64 的奇数乘法是双射，保证唯一）
+        CounterRng keyRng(seed, STREAM_UNIQUE_INTEGER, 0);
+        FeistelPermutation permutation(static_cast<uint64_t>(size), keyRng());
+        generateFixed<int64_t>(filename, size, STREAM_UNIQUE_INTEGER, "生成整数数据",
+            [&permutation](CounterRng&, int64_t first, int64_t* out, size_t n) {
+                const uint64_t multiplier = 6364136223846793005ULL;
+                const uint64_t increment = 1442695040888963407ULL;
+                // 有符号与无符号整数可以互相别名访问，直接在输出缓冲区中计算
+                uint64_t* values = reinterpret_cast<uint64_t*>(out);
+                permutation.apply(first, values, n);
+                for (size_t j = 0; j < n; j++) {
+                    values[j] = values[j] * multiplier + increment;
+                }
+            });
+    }
 
-        for (int64_t j = 0; j < batchSize; j++) {
-            batch[j] = dist(engine);
-        }
+    cout << "整数数据生成完成: " << filename << " (大小: " << size << ")" << endl;
+}
 
-        outFile.write(reinterpret_cast<const char*>(batch.data()),
-                     batchSize * sizeof(double));
+void DataGenerator::generateDoubleData(const std::string& filename,
+                                       int64_t size,
+                                       bool allowDuplicates) {
 
-        if (i > 0 && i % (10 * BATCH_SIZE) == 0) {
-            cout << "生成浮点数数据进度: " << (i * 100.0 / size) << "%" << endl;
-        }
-    }
+    generateFixed<double>(filename, size, STREAM_DOUBLE, "生成浮点数数据",
+        [](CounterRng& rng, int64_t, double* out, size_t n) {
+            for (size_t j = 0; j < n; j++) {
+                out[j] = -1000000.0 + rng.unit() * 2000000.0;
+            }
+        });
 
-    outFile.close();
     cout << "浮点数数据生成完成: " << filename << " (大小: " << size << ")" << endl;
 }
 
-std::string DataGenerator::generateRandomString(size_t minLen, size_t maxLen) {
+void DataGenerator::appendRandomString(CounterRng& rng, size_t minLen, size_t maxLen, std::string& out) {
     static const char charset[] =
         "0123456789"
         "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
         "abcdefghijklmnopqrstuvwxyz";
 
-    auto& engine = getRandomEngine();
-    uniform_int_distribution<size_t> lengthDist(minLen, maxLen);
-    uniform_int_distribution<size_t> charDist(0, sizeof(charset) - 2);
-
-    size_t length = lengthDist(engine);
-    string str;
-    str.reserve(length);
-
+    size_t length = minLen + rng.below(maxLen - minLen + 1);
     for (size_t i = 0; i < length; i++) {
-        str += charset[charDist(engine)];
+        out += charset[rng.below(sizeof(charset) - 1)];
     }
-
-    return str;
 }
 
 void DataGenerator::generateStringData(const std::string& filename,
                                        int64_t size,
                                        bool allowDuplicates) {
 
-    ofstream outFile(filename);
-    if (!outFile) {
-        throw runtime_error("无法打开文件: " + filename);
-    }
-
-    const int64_t BATCH_SIZE = 100000;
     const size_t MIN_LEN = 5;
     const size_t MAX_LEN = 50;
 
-    for (int64_t i = 0; i < size; i++) {
-        string randomStr = generateRandomString(MIN_LEN, MAX_LEN);
-        outFile << randomStr << "\n";
+    generateLines(filename, size, STREAM_STRING, "生成字符串数据",
+        [](CounterRng& rng, int64_t, int64_t n, string& out) {
+            for (int64_t i = 0; i < n; i++) {
+                appendRandomString(rng, MIN_LEN, MAX_LEN, out);
+                out += '\n';
+            }
+        });
+
+    cout << "字符串数据生成完成: " << filename << " (大小: " << size << ")" << endl;
+}
+
+void DataGenerator::generateDistributionData(const std::string& filename,
+                                             int64_t size,
+                                             Distribution distribution,
+                                             DataType type) {
+    if (type == DataType::STRING) {
+        throw invalid_argument("输入分布只支持整数/浮点数数据");
+    }
 
-        if (i > 0 && i % (10 * BATCH_SIZE) == 0) {
-            cout << "生成字符串数据进度: " << (i * 100.0 / size) << "%" << endl;
+    const DistributionOptions& options = distributionOptions;
+    vector<double> zipfCdf;
+    if (distribution == Distribution::ZIPF) {
+        // 取值 k 的概率正比于 1 / (k + 1)^s，按累积分布二分查找
+        zipfCdf.resize(options.zipfRange);
+        double total = 0;
+        for (int64_t k = 0; k < options.zipfRange; k++) {
+            total += 1.0 / pow(k + 1.0, options.zipfExponent);
+            zipfCdf[k] = total;
+        }
+        for (double& p : zipfCdf) {
+            p /= total;
         }
     }
 
-    outFile.close();
-    cout << "字符串数据生成完成: " << filename << " (大小: " << size << ")" << endl;
+    uint64_t stream = STREAM_DISTRIBUTION + static_cast<uint64_t>(distribution);
+    CounterRng keyRng(seed, stream, 0);
+    SwapPairs swaps(size, options.swapPercent, keyRng());
+    string label = string("生成") + distributionName(distribution) + "数据";
+    if (type == DataType::INTEGER) {
+        generateFixed<int64_t>(filename, size, stream, label,
+            [&](CounterRng& rng, int64_t first, int64_t* out, size_t n) {
+                fillDistribution(distribution, options, zipfCdf, swaps, rng, first, size, out, n);
+            });
+    } else {
+        generateFixed<double>(filename, size, stream, label,
+            [&](CounterRng& rng, int64_t first, double* out, size_t n) {
+                fillDistribution(distribution, options, zipfCdf, swaps, rng, first, size, out, n);
+            });
+    }
+
+    cout << distributionName(distribution) << " 数据生成完成: " << filename << " (大小: " << size << ")" << endl;
 }
 
-// 从二进制文件读取整数数据
-std::vector<int64_t> DataGenerator::readIntegerData(const std::string& filename) {
-    ifstream inFile(filename, ios::binary | ios::ate);
-    if (!inFile) {
-        throw runtime_error("无法打开文件: " + filename);
+void DataGenerator::setDistributionOptions(const DistributionOptions& options) {
+    if (options.swapPercent < 0 || options.swapPercent > 100 || options.runCount < 1 ||
+        options.uniqueValues < 1 || options.zipfExponent <= 0 || options.zipfRange < 1) {
+        throw invalid_argument("无效的分布参数");
     }
+    distributionOptions = options;
+}
 
-    // 获取文件大小
-    streamsize fileSize = inFile.tellg();
-    inFile.seekg(0, ios::beg);
+const char* DataGenerator::distributionName(Distribution distribution) {
+    switch (distribution) {
+        case Distribution::UNIFORM:        return "uniform";
+        case Distribution::SORTED:         return "sorted";
+        case Distribution::REVERSE_SORTED: return "reverse";
+        case Distribution::NEARLY_SORTED:  return "nearly-sorted";
+        case Distribution::ORGAN_PIPE:     return "organ-pipe";
+        case Distribution::SAWTOOTH:       return "sawtooth";
+        case Distribution::FEW_UNIQUE:     return "few-unique";
+        case Distribution::ALL_EQUAL:      return "all-equal";
+        case Distribution::ZIPF:           return "zipf";
+        case Distribution::SORTED_RUNS:    return "sorted-runs";
+        case Distribution::MEDIAN3_KILLER: return "median3-killer";
+    }
+    return "unknown";
+}
 
-    // 计算元素数量
-    size_t elementCount = fileSize / sizeof(int64_t);
-    vector<int64_t> data(elementCount);
+bool DataGenerator::parseDistribution(const std::string& name, Distribution& distribution) {
+    for (Distribution candidate : allDistributions()) {
+        if (name == distributionName(candidate)) {
+            distribution = candidate;
+            return true;
+        }
+    }
+    return false;
+}
 
-    // 读取数据
-    inFile.read(reinterpret_cast<char*>(data.data()), fileSize);
-    inFile.close();
+std::vector<Distribution> DataGenerator::allDistributions() {
+    return {Distribution::UNIFORM, Distribution::SORTED, Distribution::REVERSE_SORTED,
+            Distribution::NEARLY_SORTED, Distribution::ORGAN_PIPE, Distribution::SAWTOOTH,
+            Distribution::FEW_UNIQUE, Distribution::ALL_EQUAL, Distribution::ZIPF,
+            Distribution::SORTED_RUNS, Distribution::MEDIAN3_KILLER};
+}
+
+// 从二进制文件读取整数数据
+DataBuffer<int64_t> DataGenerator::readIntegerData(const std::string& filename) {
+    auto start = chrono::steady_clock::now();
 
-    cout << "读取整数数据: " << filename << " (" << elementCount << " 个元素)" << endl;
+    // 多线程 pread 直接读入未清零的缓冲区（不经过流缓冲区）
+    DataBuffer<int64_t> data = FileUtils::readBinaryFile<int64_t>(filename);
+
+    loadSeconds += secondsSince(start);
+    cout << "读取整数数据: " << filename << " (" << data.size() << " 个元素)" << endl;
     return data;
 }
 
 // 从二进制文件读取浮点数数据
-std::vector<double> DataGenerator::readDoubleData(const std::string& filename) {
-    ifstream inFile(filename, ios::binary | ios::ate);
-    if (!inFile) {
-        throw runtime_error("无法打开文件: " + filename);
-    }
+DataBuffer<double> DataGenerator::readDoubleData(const std::string& filename) {
+    auto start = chrono::steady_clock::now();
+
+    DataBuffer<double> data = FileUtils::readBinaryFile<double>(filename);
 
-    // 获取文件大小
-    streamsize fileSize = inFile.tellg();
-    inFile.seekg(0, ios::beg);
+    loadSeconds += secondsSince(start);
+    cout << "读取浮点数数据: " << filename << " (" << data.size() << " 个元素)" << endl;
+    return data;
+}
 
-    // 计算元素数量
-    size_t elementCount = fileSize / sizeof(double);
-    vector<double> data(elementCount);
+// 写出整数数据
+void DataGenerator::writeIntegerData(const std::string& filename, const DataBuffer<int64_t>& data, bool withHeader) {
+    FileUtils::writeDataFile(filename, data.data(), data.size(), withHeader);
+}
 
-    // 读取数据
-    inFile.read(reinterpret_cast<char*>(data.data()), fileSize);
-    inFile.close();
+// 写出浮点数数据
+void DataGenerator::writeDoubleData(const std::string& filename, const DataBuffer<double>& data, bool withHeader) {
+    FileUtils::writeDataFile(filename, data.data(), data.size(), withHeader);
+}
 
-    cout << "读取浮点数数据: " << filename << " (" << elementCount << " 个元素)" << endl;
-    return data;
+bool DataGenerator::hasDataHeader(const std::string& filename) {
+    return FileUtils::dataOffset(filename) > 0;
+}
+
+bool DataGenerator::isMarkedSorted(const std::string& filename) {
+    DataFileHeader header;
+    return FileUtils::readDataHeader(filename, header) && header.sorted();
+}
+
+// 映射整数数据：预读全部页面，PRIVATE 模式下可原地排序
+MappedFile<int64_t> DataGenerator::mapIntegerData(const std::string& filename, MapMode mode) {
+    auto start = chrono::steady_clock::now();
+    MappedFile<int64_t> view(filename, mode, 0, MAP_HINT_POPULATE | MAP_HINT_HUGE_PAGES);
+    loadSeconds += secondsSince(start);
+    cout << "映射整数数据: " << filename << " (" << view.size() << " 个元素)" << endl;
+    return view;
+}
+
+// 映射浮点数数据
+MappedFile<double> DataGenerator::mapDoubleData(const std::string& filename, MapMode mode) {
+    auto start = chrono::steady_clock::now();
+    MappedFile<double> view(filename, mode, 0, MAP_HINT_POPULATE | MAP_HINT_HUGE_PAGES);
+    loadSeconds += secondsSince(start);
+    cout << "映射浮点数数据: " << filename << " (" << view.size() << " 个元素)" << endl;
+    return view;
 }
 
-// 从文本文件读取字符串数据
+// 读取字符串数据
 std::vector<std::string> DataGenerator::readStringData(const std::string& filename) {
-    ifstream inFile(filename);
-    if (!inFile) {
-        throw runtime_error("无法打开文件: " + filename);
-    }
+    auto start = chrono::steady_clock::now();
 
+    // 二进制格式按偏移表直接取出；文本格式映射整个文件并行切分行，再一次性复制为字符串
     vector<string> data;
-    string line;
-
-    while (getline(inFile, line)) {
-        data.push_back(line);
+    if (FileUtils::isBinaryStringFile(filename)) {
+        BinaryStrings strings(filename);
+        data.reserve(strings.size());
+        for (size_t i = 0; i < strings.size(); i++) {
+            data.emplace_back(strings[i]);
+        }
+    } else {
+        data = TextLines(filename).toStrings();
     }
 
-    inFile.close();
+    loadSeconds += secondsSince(start);
     cout << "读取字符串数据: " << filename << " (" << data.size() << " 个元素)" << endl;
     return data;
 }
 
+// 读取字符串列
+StringColumn DataGenerator::readStringColumn(const std::string& filename) {
+    auto start = chrono::steady_clock::now();
+
+    StringColumn column = FileUtils::isBinaryStringFile(filename)
+        ? StringColumn::fromBinaryFile(filename)
+        : StringColumn::fromTextFile(filename);
+
+    loadSeconds += secondsSince(start);
+    cout << "读取字符串数据: " << filename << " (" << column.size() << " 个元素)" << endl;
+    return column;
+}
+
 // 验证整数文件是否已排序
 bool DataGenerator::verifyIntegerSorted(const std::string& filename) {
     ifstream inFile(filename, ios::binary);
@@ -244,6 +536,14 @@ bool DataGenerator::verifyIntegerSorted(const std::string& filename) {
         throw runtime_error("无法打开文件: " + filename);
     }
 
+    // 带文件头时跳过文件头，并在读完后核对文件头的统计信息
+    DataFileHeader header;
+    bool headered = FileUtils::readDataHeader(filename, header, DataFileHeader::typeOf<int64_t>());
+    DataHeaderBuilder<int64_t> actual;
+    if (headered) {
+        inFile.seekg(sizeof(DataFileHeader));
+    }
+
     const size_t BATCH_SIZE = 1000000;
     vector<int64_t> buffer(BATCH_SIZE);
     int64_t previous = LLONG_MIN;
@@ -252,6 +552,9 @@ bool DataGenerator::verifyIntegerSorted(const std::string& filename) {
     while (inFile) {
         inFile.read(reinterpret_cast<char*>(buffer.data()), BATCH_SIZE * sizeof(int64_t));
         size_t count = inFile.gcount() / sizeof(int64_t);
+        if (headered) {
+            actual.add(buffer.data(), count);
+        }
 
         for (size_t i = 0; i < count; i++) {
             if (buffer[i] < previous) {
@@ -268,6 +571,10 @@ bool DataGenerator::verifyIntegerSorted(const std::string& filename) {
     }
 
     inFile.close();
+    if (headered && !headerMatches(header, actual.header())) {
+        cout << "整数文件的文件头与数据不符: " << filename << endl;
+        return false;
+    }
     cout << "整数文件验证完成: " << filename << " (有序: 是)" << endl;
     return true;
 }
@@ -279,6 +586,14 @@ bool DataGenerator::verifyDoubleSorted(const std::string& filename) {
         throw runtime_error("无法打开文件: " + filename);
     }
 
+    // 带文件头时跳过文件头，并在读完后核对文件头的统计信息
+    DataFileHeader header;
+    bool headered = FileUtils::readDataHeader(filename, header, DataFileHeader::typeOf<double>());
+    DataHeaderBuilder<double> actual;
+    if (headered) {
+        inFile.seekg(sizeof(DataFileHeader));
+    }
+
     const size_t BATCH_SIZE = 1000000;
     vector<double> buffer(BATCH_SIZE);
     double previous = -DBL_MAX;
@@ -287,6 +602,9 @@ bool DataGenerator::verifyDoubleSorted(const std::string& filename) {
     while (inFile) {
         inFile.read(reinterpret_cast<char*>(buffer.data()), BATCH_SIZE * sizeof(double));
         size_t count = inFile.gcount() / sizeof(double);
+        if (headered) {
+            actual.add(buffer.data(), count);
+        }
 
         for (size_t i = 0; i < count; i++) {
             if (buffer[i] < previous) {
@@ -303,6 +621,10 @@ bool DataGenerator::verifyDoubleSorted(const std::string& filename) {
     }
 
     inFile.close();
+    if (headered && !headerMatches(header, actual.header())) {
+        cout << "浮点数文件的文件头与数据不符: " << filename << endl;
+        return false;
+    }
     cout << "浮点数文件验证完成: " << filename << " (有序: 是)" << endl;
     return true;
 }
@@ -340,158 +662,103 @@ bool DataGenerator::verifyStringSorted(const std::string& filename) {
 
 // 生成更真实的整数数据（模拟真实世界分布）
 void DataGenerator::generateRealisticIntegerData(const std::string& filename, int64_t size) {
-    ofstream outFile(filename, ios::binary);
-    if (!outFile) {
-        throw runtime_error("无法打开文件: " + filename);
-    }
-
-    const int64_t BATCH_SIZE = 1000000;
-    auto& engine = getRandomEngine();
-
-    // 使用多种分布组合生成更真实的数据
-    // 1. 正态分布（模拟大多数数据集中在平均值附近）
-    normal_distribution<double> normalDist(0.0, 10000.0);
-
-    // 2. 均匀分布（模拟随机数据）
-    uniform_int_distribution<int64_t> uniformDist(-1000000, 1000000);
-
-    // 3. 指数分布（模拟长尾数据）
-    exponential_distribution<double> expDist(0.0001);
-
-    for (int64_t i = 0; i < size; i += BATCH_SIZE) {
-        int64_t batchSize = min(BATCH_SIZE, size - i);
-        vector<int64_t> batch(batchSize);
-
-        for (int64_t j = 0; j < batchSize; j++) {
-            // 随机选择一种分布生成数据
-            double choice = uniform_int_distribution<>(0, 100)(engine) / 100.0;
-
-            if (choice < 0.6) {
-                // 60% 的数据使用正态分布
-                batch[j] = static_cast<int64_t>(normalDist(engine));
-            } else if (choice < 0.9) {
-                // 30% 的数据使用均匀分布
-                batch[j] = uniformDist(engine);
-            } else {
-                // 10% 的数据使用指数分布（长尾）
-                batch[j] = static_cast<int64_t>(expDist(engine) * 10000);
+    generateFixed<int64_t>(filename, size, STREAM_REALISTIC_INTEGER, "生成真实整数数据",
+        [](CounterRng& rng, int64_t, int64_t* out, size_t n) {
+            // 使用多种分布组合生成更真实的数据（分布对象按块创建，块之间互不影响）
+            // 1. 正态分布（模拟大多数数据集中在平均值附近）
+            normal_distribution<double> normalDist(0.0, 10000.0);
+
+            // 2. 指数分布（模拟长尾数据）
+            exponential_distribution<double> expDist(0.0001);
+
+            for (size_t j = 0; j < n; j++) {
+                // 随机选择一种分布生成数据
+                double choice = rng.below(101) / 100.0;
+
+                if (choice < 0.6) {
+                    // 60% 的数据使用正态分布
+                    out[j] = static_cast<int64_t>(normalDist(rng));
+                } else if (choice < 0.9) {
+                    // 30% 的数据使用均匀分布
+                    out[j] = static_cast<int64_t>(rng.below(2000001)) - 1000000;
+                } else {
+                    // 10% 的数据使用指数分布（长尾）
+                    out[j] = static_cast<int64_t>(expDist(rng) * 10000);
+                }
             }
-        }
-
-        outFile.write(reinterpret_cast<const char*>(batch.data()),
-                     batchSize * sizeof(int64_t));
-
-        if (i > 0 && i % (10 * BATCH_SIZE) == 0) {
-            cout << "生成真实整数数据进度: " << (i * 100.0 / size) << "%" << endl;
-        }
-    }
+        });
 
-    outFile.close();
     cout << "真实整数数据生成完成: " << filename << endl;
 }
 
 // 生成更真实的浮点数数据
 void DataGenerator::generateRealisticDoubleData(const std::string& filename, int64_t size) {
-    ofstream outFile(filename, ios::binary);
-    if (!outFile) {
-        throw runtime_error("无法打开文件: " + filename);
-    }
-
-    const int64_t BATCH_SIZE = 1000000;
-    auto& engine = getRandomEngine();
-
-    // 使用多种分布
-    normal_distribution<double> normalDist(0.0, 1.0);
-    uniform_real_distribution<double> uniformDist(-1000.0, 1000.0);
-    exponential_distribution<double> expDist(1.0);
-
-    for (int64_t i = 0; i < size; i += BATCH_SIZE) {
-        int64_t batchSize = min(BATCH_SIZE, size - i);
-        vector<double> batch(batchSize);
-
-        for (int64_t j = 0; j < batchSize; j++) {
-            double choice = uniform_int_distribution<>(0, 100)(engine) / 100.0;
-
-            if (choice < 0.7) {
-                // 70% 正态分布
-                batch[j] = normalDist(engine);
-            } else if (choice < 0.95) {
-                // 25% 均匀分布
-                batch[j] = uniformDist(engine);
-            } else {
-                // 5% 指数分布（异常值）
-                batch[j] = expDist(engine) * 100;
+    generateFixed<double>(filename, size, STREAM_REALISTIC_DOUBLE, "生成真实浮点数数据",
+        [](CounterRng& rng, int64_t, double* out, size_t n) {
+            // 使用多种分布
+            normal_distribution<double> normalDist(0.0, 1.0);
+            exponential_distribution<double> expDist(1.0);
+
+            for (size_t j = 0; j < n; j++) {
+                double choice = rng.below(101) / 100.0;
+
+                if (choice < 0.7) {
+                    // 70% 正态分布
+                    out[j] = normalDist(rng);
+                } else if (choice < 0.95) {
+                    // 25% 均匀分布
+                    out[j] = -1000.0 + rng.unit() * 2000.0;
+                } else {
+                    // 5% 指数分布（异常值）
+                    out[j] = expDist(rng) * 100;
+                }
             }
-        }
-
-        outFile.write(reinterpret_cast<const char*>(batch.data()),
-                     batchSize * sizeof(double));
+        });
 
-        if (i > 0 && i % (10 * BATCH_SIZE) == 0) {
-            cout << "生成真实浮点数数据进度: " << (i * 100.0 / size) << "%" << endl;
-        }
-    }
-
-    outFile.close();
     cout << "真实浮点数数据生成完成: " << filename << endl;
 }
 
 // 生成更真实的字符串数据
 void DataGenerator::generateRealisticStringData(const std::string& filename, int64_t size) {
-    ofstream outFile(filename);
-    if (!outFile) {
-        throw runtime_error("无法打开文件: " + filename);
-    }
-
-    auto& engine = getRandomEngine();
-
     // 模拟真实世界的字符串数据
-    vector<string> firstName = {"John", "Jane", "Bob", "Alice", "Charlie", "David", "Eve", "Frank"};
-    vector<string> lastName = {"Smith", "Johnson", "Williams", "Brown", "Jones", "Miller", "Davis", "Wilson"};
-    vector<string> cities = {"New York", "London", "Tokyo", "Paris", "Beijing", "Sydney", "Berlin", "Moscow"};
-    vector<string> domains = {"gmail.com", "yahoo.com", "hotmail.com", "outlook.com"};
-
-    uniform_int_distribution<size_t> firstDist(0, firstName.size() - 1);
-    uniform_int_distribution<size_t> lastDist(0, lastName.size() - 1);
-    uniform_int_distribution<size_t> cityDist(0, cities.size() - 1);
-    uniform_int_distribution<size_t> domainDist(0, domains.size() - 1);
-    uniform_int_distribution<int> yearDist(1980, 2020);
-    uniform_int_distribution<int> numDist(1, 999);
-
-    for (int64_t i = 0; i < size; i++) {
-        stringstream ss;
-
-        // 随机生成一种类型的字符串
-        int type = uniform_int_distribution<>(0, 3)(engine);
-
-        switch (type) {
-            case 0: // 姓名
-                ss << firstName[firstDist(engine)] << " " << lastName[lastDist(engine)];
-                break;
-            case 1: // 电子邮件
-                ss << firstName[firstDist(engine)] << "."
-                   << lastName[lastDist(engine)] << numDist(engine)
-                   << "@" << domains[domainDist(engine)];
-                break;
-            case 2: // 地址
-                ss << numDist(engine) << " " << lastName[lastDist(engine)]
-                   << " St, " << cities[cityDist(engine)];
-                break;
-            case 3: // 日期
-                ss << yearDist(engine) << "-"
-                   << setw(2) << setfill('0') << uniform_int_distribution<>(1, 12)(engine)
-                   << "-" << setw(2) << setfill('0') << uniform_int_distribution<>(1, 28)(engine);
-                break;
-        }
-
-        outFile << ss.str() << "\n";
-
-        if (i > 0 && i % 100000 == 0) {
-            cout << "生成真实字符串数据进度: " << (i * 100.0 / size) << "%" << endl;
-        }
-    }
+    static const char* firstName[] = {"John", "Jane", "Bob", "Alice", "Charlie", "David", "Eve", "Frank"};
+    static const char* lastName[] = {"Smith", "Johnson", "Williams", "Brown", "Jones", "Miller", "Davis", "Wilson"};
+    static const char* cities[] = {"New York", "London", "Tokyo", "Paris", "Beijing", "Sydney", "Berlin", "Moscow"};
+    static const char* domains[] = {"gmail.com", "yahoo.com", "hotmail.com", "outlook.com"};
+
+    generateLines(filename, size, STREAM_REALISTIC_STRING, "生成真实字符串数据",
+        [](CounterRng& rng, int64_t, int64_t n, string& out) {
+            auto pick = [&rng](const char* const* names, size_t count) { return names[rng.below(count)]; };
+            auto number = [&rng]() { return to_string(1 + rng.below(999)); };
+
+            for (int64_t i = 0; i < n; i++) {
+                // 随机生成一种类型的字符串
+                switch (rng.below(4)) {
+                    case 0: // 姓名
+                        out.append(pick(firstName, 8)).append(" ").append(pick(lastName, 8));
+                        break;
+                    case 1: // 电子邮件
+                        out.append(pick(firstName, 8)).append(".").append(pick(lastName, 8))
+                           .append(number()).append("@").append(pick(domains, 4));
+                        break;
+                    case 2: // 地址
+                        out.append(number()).append(" ").append(pick(lastName, 8))
+                           .append(" St, ").append(pick(cities, 8));
+                        break;
+                    case 3: { // 日期
+                        char date[16];
+                        int year = 1980 + static_cast<int>(rng.below(41));
+                        int month = 1 + static_cast<int>(rng.below(12));
+                        int day = 1 + static_cast<int>(rng.below(28));
+                        snprintf(date, sizeof(date), "%d-%02d-%02d", year, month, day);
+                        out.append(date);
+                        break;
+                    }
+                }
+                out += '\n';
+            }
+        });
 
-    outFile.close();
     cout << "真实字符串数据生成完成: " << filename << endl;
 }
 
@@ -0,0 +1,302 @@
+#include "direct_io.h"
+#include <iostream>
+#include <stdexcept>
+#include <cstring>
+#include <cstdlib>
+#include <cerrno>
+#include <algorithm>
+
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#include <malloc.h>
+#else
+#include <unistd.h>
+#include <fcntl.h>
+#endif
+
+using namespace std;
+
+namespace {
+
+const uint64_t ALIGN = AlignedBufferPool::ALIGNMENT;
+
+uint64_t alignDown(uint64_t value) { return value / ALIGN * ALIGN; }
+uint64_t alignUp(uint64_t value) { return (value + ALIGN - 1) / ALIGN * ALIGN; }
+
+// 直接 I/O 的对齐读写每次最多搬运的字节数
+const size_t BOUNCE_BYTES = 4 << 20;
+
+#ifdef _WIN32
+// Windows 下无 pread/pwrite：只用于单线程的普通 I/O 退化路径
+ssize_t pread(int fd, void* buf, size_t n, uint64_t offset) {
+    if (_lseeki64(fd, offset, SEEK_SET) < 0) return -1;
+    return _read(fd, buf, static_cast<unsigned>(n));
+}
+
+ssize_t pwrite(int fd, const void* buf, size_t n, uint64_t offset) {
+    if (_lseeki64(fd, offset, SEEK_SET) < 0) return -1;
+    return _write(fd, buf, static_cast<unsigned>(n));
+}
+#endif
+
+// 读取最多 n 字节，返回实际读取数（到达文件末尾时变少）
+size_t readSome(int fd, char* dst, size_t n, uint64_t offset) {
+    size_t total = 0;
+    while (total < n) {
+        ssize_t r = pread(fd, dst + total, n - total, offset + total);
+        if (r < 0) {
+            if (errno == EINTR) continue;
+            throw runtime_error(string("读取失败: ") + strerror(errno));
+        }
+        if (r == 0) break;
+        total += r;
+    }
+    return total;
+}
+
+void writeAll(int fd, const char* src, size_t n, uint64_t offset) {
+    while (n > 0) {
+        ssize_t w = pwrite(fd, src, n, offset);
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            throw runtime_error(string("写入失败: ") + strerror(errno));
+        }
+        src += w;
+        n -= w;
+        offset += w;
+    }
+}
+
+} // namespace
+
+// AlignedBufferPool 实现
+AlignedBufferPool& AlignedBufferPool::instance() {
+    static AlignedBufferPool pool;
+    return pool;
+}
+
+char* AlignedBufferPool::acquire(size_t size) {
+    size = alignUp(max<size_t>(size, 1));
+    {
+        lock_guard<std::mutex> lock(poolMutex);
+        auto it = freeBuffers.find(size);
+        if (it != freeBuffers.end()) {
+            char* buffer = it->second;
+            freeBuffers.erase(it);
+            return buffer;
+        }
+    }
+
+    void* buffer = nullptr;
+#ifdef _WIN32
+    buffer = _aligned_malloc(size, ALIGNMENT);
+#else
+    if (posix_memalign(&buffer, ALIGNMENT, size) != 0) buffer = nullptr;
+#endif
+    if (!buffer) {
+        throw bad_alloc();
+    }
+    return static_cast<char*>(buffer);
+}
+
+void AlignedBufferPool::release(char* buffer, size_t size) {
+    if (!buffer) return;
+    lock_guard<std::mutex> lock(poolMutex);
+    freeBuffers.insert({alignUp(max<size_t>(size, 1)), buffer});
+}
+
+AlignedBufferPool::~AlignedBufferPool() {
+    for (auto& entry : freeBuffers) {
+#ifdef _WIN32
+        _aligned_free(entry.second);
+#else
+        free(entry.second);
+#endif
+    }
+}
+
+// AlignedBuffer 实现
+AlignedBuffer::AlignedBuffer(size_t size)
+    : buffer(AlignedBufferPool::instance().acquire(size)), capacity(alignUp(max<size_t>(size, 1))) {}
+
+AlignedBuffer::~AlignedBuffer() {
+    AlignedBufferPool::instance().release(buffer, capacity);
+}
+
+// DirectFile 实现
+DirectFile::DirectFile(const string& path, bool write, bool direct)
+    : path(path), bufferedFd(-1), directFd(-1) {
+#ifdef _WIN32
+    int flags = write ? (_O_RDWR | _O_CREAT | _O_TRUNC | _O_BINARY) : (_O_RDONLY | _O_BINARY);
+    bufferedFd = _open(path.c_str(), flags, 0644);
+#else
+    int flags = write ? (O_RDWR | O_CREAT | O_TRUNC) : O_RDONLY;
+    bufferedFd = open(path.c_str(), flags, 0644);
+#endif
+    if (bufferedFd < 0) {
+        throw runtime_error("无法打开文件: " + path);
+    }
+    directFd = bufferedFd;
+
+#if !defined(_WIN32) && defined(O_DIRECT)
+    if (direct) {
+        int fd = open(path.c_str(), (write ? O_RDWR : O_RDONLY) | O_DIRECT);
+        if (fd >= 0) {
+            directFd = fd;
+        } else {
+            cerr << "警告: " << path << " 不支持 O_DIRECT，使用普通 I/O" << endl;
+        }
+    }
+#else
+    (void)direct;
+#endif
+}
+
+DirectFile::~DirectFile() {
+    try {
+        close();
+    } catch (const exception&) {
+        // 析构时忽略关闭错误
+    }
+}
+
+void DirectFile::readAt(void* dst, size_t n, uint64_t offset) {
+    char* out = static_cast<char*>(dst);
+
+    if (!isDirect()) {
+        if (readSome(bufferedFd, out, n, offset) != n) {
+            throw runtime_error("文件意外结束: " + path);
+        }
+        return;
+    }
+
+    // 读取覆盖目标范围的对齐区间，再拷贝出需要的部分
+    AlignedBuffer bounce(BOUNCE_BYTES);
+    while (n > 0) {
+        uint64_t start = alignDown(offset);
+        size_t lead = offset - start;
+        size_t span = min<uint64_t>(alignUp(lead + n), bounce.size());
+        size_t got = readSome(directFd, bounce.data(), span, start);
+        if (got <= lead) {
+            throw runtime_error("文件意外结束: " + path);
+        }
+        size_t take = min(n, got - lead);
+        memcpy(out, bounce.data() + lead, take);
+        out += take;
+        offset += take;
+        n -= take;
+        if (n > 0 && got < span) {
+            throw runtime_error("文件意外结束: " + path);
+        }
+    }
+}
+
+void DirectFile::writeAt(const void* src, size_t n, uint64_t offset) {
+    const char* in = static_cast<const char*>(src);
+
+    if (!isDirect()) {
+        writeAll(bufferedFd, in, n, offset);
+        return;
+    }
+
+    // 非对齐的头
+    size_t head = min<uint64_t>(n, alignUp(offset) - offset);
+    if (head > 0) {
+        writeAll(bufferedFd, in, head, offset);
+        in += head;
+        offset += head;
+        n -= head;
+    }
+
+    // 对齐的整块（缓冲区地址不对齐时经对齐缓冲区中转）
+    size_t body = alignDown(n);
+    if (body > 0) {
+        if (reinterpret_cast<uintptr_t>(in) % ALIGN == 0) {
+            writeAll(directFd, in, body, offset);
+        } else {
+            AlignedBuffer bounce(min(body, BOUNCE_BYTES));
+            for (size_t done = 0; done < body; ) {
+                size_t chunk = min(body - done, bounce.size());
+                memcpy(bounce.data(), in + done, chunk);
+                writeAll(directFd, bounce.data(), chunk, offset + done);
+                done += chunk;
+            }
+        }
+        in += body;
+        offset += body;
+        n -= body;
+    }
+
+    // 非对齐的尾
+    if (n > 0) {
+        writeAll(bufferedFd, in, n, offset);
+    }
+}
+
+void DirectFile::truncate(uint64_t size) {
+#ifdef _WIN32
+    int rc = _chsize_s(bufferedFd, size);
+#else
+    int rc = ftruncate(bufferedFd, size);
+#endif
+    if (rc != 0) {
+        throw runtime_error("无法调整文件大小: " + path);
+    }
+}
+
+void DirectFile::close() {
+    bool failed = false;
+    if (directFd >= 0 && directFd != bufferedFd) {
+#ifndef _WIN32
+        failed |= ::close(directFd) != 0;
+#endif
+    }
+    if (bufferedFd >= 0) {
+#ifdef _WIN32
+        failed |= _close(bufferedFd) != 0;
+#else
+        failed |= ::close(bufferedFd) != 0;
+#endif
+    }
+    directFd = bufferedFd = -1;
+    if (failed) {
+        throw runtime_error("关闭文件失败: " + path);
+    }
+}
+
+// DirectFileWriter 实现
+DirectFileWriter::DirectFileWriter(DirectFile& file, uint64_t startOffset, size_t blockSize)
+    : file(file), buffer(alignUp(max<size_t>(blockSize, ALIGN))), written(0) {
+    // 缓冲区下标与文件偏移对 ALIGN 同余，整块写出时地址和偏移都对齐
+    blockStart = alignDown(startOffset);
+    begin = used = startOffset - blockStart;
+}
+
+void DirectFileWriter::append(const void* data, size_t n) {
+    const char* in = static_cast<const char*>(data);
+    while (n > 0) {
+        size_t chunk = min(n, buffer.size() - used);
+        memcpy(buffer.data() + used, in, chunk);
+        used += chunk;
+        in += chunk;
+        n -= chunk;
+        if (used == buffer.size()) {
+            flush();
+        }
+    }
+}
+
+void DirectFileWriter::flush() {
+    if (used > begin) {
+        file.writeAt(buffer.data() + begin, used - begin, blockStart + begin);
+        written += used - begin;
+    }
+    blockStart += used;
+    begin = used = 0;
+}
+
+uint64_t DirectFileWriter::finish() {
+    flush();
+    return written;
+}
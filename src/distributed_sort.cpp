@@ -0,0 +1,641 @@
+#include "distributed_sort.h"
+#include "external_sort.h"
+#include "file_utils.h"
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <stdexcept>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <cstring>
+#include <cerrno>
+#include <ctime>
+
+#ifndef _WIN32
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <sys/stat.h>
+#endif
+
+using namespace std;
+
+size_t DistributedSort::samplesPerWorker = 1024;
+DistributedSortStats DistributedSort::lastStats;
+
+namespace {
+
+double secondsSince(chrono::steady_clock::time_point start) {
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+#ifndef _WIN32
+
+// 控制消息类型（协调进程与工作进程之间的 socketpair）
+enum MessageType : uint8_t {
+    MSG_SAMPLES = 1,    // 工作进程 → 协调进程：分片采样
+    MSG_SPLITTERS,      // 协调进程 → 工作进程：分割点
+    MSG_COUNT,          // 工作进程 → 协调进程：本地排序完成，区间元素数
+    MSG_OFFSET,         // 协调进程 → 工作进程：区间在输出中的起始元素
+    MSG_REPORT,         // 工作进程 → 协调进程：统计
+    MSG_ERROR           // 工作进程 → 协调进程：错误信息
+};
+
+// 洗牌时每个目标进程的发送批大小
+const size_t SHUFFLE_BATCH = 256 * 1024;
+
+// 顺序读写的块大小
+const size_t COPY_BLOCK = 1 << 20;
+
+void sendAll(int fd, const void* data, size_t n) {
+    const char* p = static_cast<const char*>(data);
+    while (n > 0) {
+        ssize_t sent = send(fd, p, n, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) continue;
+            throw runtime_error(string("发送失败: ") + strerror(errno));
+        }
+        p += sent;
+        n -= sent;
+    }
+}
+
+// 读满 n 字节；对端在消息边界处关闭时返回 false
+bool recvAll(int fd, void* data, size_t n) {
+    char* p = static_cast<char*>(data);
+    size_t got = 0;
+    while (got < n) {
+        ssize_t r = recv(fd, p + got, n - got, 0);
+        if (r < 0) {
+            if (errno == EINTR) continue;
+            throw runtime_error(string("接收失败: ") + strerror(errno));
+        }
+        if (r == 0) {
+            if (got == 0) return false;
+            throw runtime_error("连接意外断开");
+        }
+        got += r;
+    }
+    return true;
+}
+
+// 控制消息：1 字节类型 + 8 字节长度 + 负载
+void sendMessage(int fd, MessageType type, const void* data, size_t n) {
+    char header[9];
+    uint64_t length = n;
+    header[0] = static_cast<char>(type);
+    memcpy(header + 1, &length, sizeof(length));
+    sendAll(fd, header, sizeof(header));
+    if (n > 0) sendAll(fd, data, n);
+}
+
+MessageType recvMessage(int fd, vector<char>& payload) {
+    char header[9];
+    uint64_t length;
+    if (!recvAll(fd, header, sizeof(header))) {
+        throw runtime_error("对端进程已退出");
+    }
+    memcpy(&length, header + 1, sizeof(length));
+    payload.resize(length);
+    if (length > 0 && !recvAll(fd, payload.data(), length)) {
+        throw runtime_error("对端进程已退出");
+    }
+    return static_cast<MessageType>(header[0]);
+}
+
+void expectMessage(int fd, MessageType expected, vector<char>& payload) {
+    MessageType type = recvMessage(fd, payload);
+    if (type == MSG_ERROR) {
+        throw runtime_error(string(payload.begin(), payload.end()));
+    }
+    if (type != expected) {
+        throw runtime_error("控制消息顺序错误");
+    }
+}
+
+// 协调进程：从每个工作进程各收一条消息（任一进程出错立即失败，不会
+// 因为按顺序等待某个被阻塞的进程而卡住）
+vector<vector<char>> gatherMessages(const vector<int>& fds, MessageType expected) {
+    size_t count = fds.size();
+    vector<vector<char>> payloads(count);
+    vector<bool> done(count, false);
+    size_t remaining = count;
+
+    while (remaining > 0) {
+        vector<pollfd> polls;
+        vector<size_t> owners;
+        for (size_t i = 0; i < count; i++) {
+            if (!done[i]) {
+                polls.push_back({fds[i], POLLIN, 0});
+                owners.push_back(i);
+            }
+        }
+        if (poll(polls.data(), polls.size(), -1) < 0) {
+            if (errno == EINTR) continue;
+            throw runtime_error(string("poll 失败: ") + strerror(errno));
+        }
+        for (size_t k = 0; k < polls.size(); k++) {
+            if (polls[k].revents == 0) continue;
+            size_t i = owners[k];
+            try {
+                expectMessage(fds[i], expected, payloads[i]);
+            } catch (const exception& e) {
+                throw runtime_error("工作进程 " + to_string(i) + " 失败: " + e.what());
+            }
+            done[i] = true;
+            remaining--;
+        }
+    }
+    return payloads;
+}
+
+sockaddr_un socketAddress(const string& path) {
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) {
+        throw runtime_error("套接字路径过长: " + path);
+    }
+    strcpy(address.sun_path, path.c_str());
+    return address;
+}
+
+int listenSocket(const string& path) {
+    sockaddr_un address = socketAddress(path);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        throw runtime_error(string("无法创建套接字: ") + strerror(errno));
+    }
+    unlink(path.c_str());
+    if (bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        listen(fd, SOMAXCONN) != 0) {
+        close(fd);
+        throw runtime_error("无法监听套接字: " + path);
+    }
+    return fd;
+}
+
+int connectSocket(const string& path) {
+    sockaddr_un address = socketAddress(path);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        throw runtime_error(string("无法创建套接字: ") + strerror(errno));
+    }
+    if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        close(fd);
+        throw runtime_error("无法连接工作进程: " + path);
+    }
+    return fd;
+}
+
+void preadAll(int fd, void* data, size_t n, uint64_t offset) {
+    char* p = static_cast<char*>(data);
+    while (n > 0) {
+        ssize_t r = pread(fd, p, n, offset);
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0) {
+            throw runtime_error("读取失败");
+        }
+        p += r;
+        n -= r;
+        offset += r;
+    }
+}
+
+void pwriteAll(int fd, const void* data, size_t n, uint64_t offset) {
+    const char* p = static_cast<const char*>(data);
+    while (n > 0) {
+        ssize_t w = pwrite(fd, p, n, offset);
+        if (w < 0 && errno == EINTR) continue;
+        if (w <= 0) {
+            throw runtime_error(string("写入失败: ") + strerror(errno));
+        }
+        p += w;
+        n -= w;
+        offset += w;
+    }
+}
+
+// 工作进程的全部流程：采样 → 洗牌 → 本地外排序 → 写入输出区间
+template<typename T>
+DistributedWorkerStats runWorker(int id, int workerCount, const string& inputFile, const string& outputFile,
+                                 const string& jobDir, const vector<string>& socketPaths,
+                                 int listenFd, int control, size_t samples,
+                                 void (*localSort)(const string&, const string&)) {
+    DistributedWorkerStats stats;
+
+    int inFd = open(inputFile.c_str(), O_RDONLY);
+    if (inFd < 0) {
+        throw runtime_error("无法打开输入文件: " + inputFile);
+    }
+    // 输入带数据文件头时数据从文件头之后开始，输出同样留出文件头
+    uint64_t base = FileUtils::dataOffset(inputFile);
+    uint64_t total = (FileUtils::getFileSize(inputFile) - base) / sizeof(T);
+    uint64_t begin = total * id / workerCount;
+    uint64_t end = total * (id + 1) / workerCount;
+
+    // 1. 分片均匀采样
+    vector<T> sample;
+    uint64_t shardCount = end - begin;
+    size_t sampleCount = min<uint64_t>(samples, shardCount);
+    for (size_t k = 0; k < sampleCount; k++) {
+        T value;
+        preadAll(inFd, &value, sizeof(T), base + (begin + shardCount * k / sampleCount) * sizeof(T));
+        sample.push_back(value);
+    }
+    sendMessage(control, MSG_SAMPLES, sample.data(), sample.size() * sizeof(T));
+
+    vector<char> payload;
+    expectMessage(control, MSG_SPLITTERS, payload);
+    vector<T> splitters(payload.size() / sizeof(T));
+    memcpy(splitters.data(), payload.data(), splitters.size() * sizeof(T));
+
+    // 2. 洗牌：接收线程把其他进程发来的元素追加到本进程的接收文件
+    auto phaseStart = chrono::steady_clock::now();
+    string receivedFile = jobDir + "/received_" + to_string(id) + ".dat";
+    int receivedFd = open(receivedFile.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (receivedFd < 0) {
+        throw runtime_error("无法创建文件: " + receivedFile);
+    }
+
+    mutex fileMutex;
+    uint64_t receivedOffset = 0;
+    atomic<uint64_t> bytesReceived(0);
+    auto appendReceived = [&](const char* data, size_t n) {
+        lock_guard<mutex> lock(fileMutex);
+        pwriteAll(receivedFd, data, n, receivedOffset);
+        receivedOffset += n;
+    };
+
+    vector<thread> receivers;
+    vector<string> errors(workerCount);
+    thread acceptor([&]() {
+        for (int k = 0; k < workerCount - 1; k++) {
+            int fd = accept(listenFd, nullptr, nullptr);
+            if (fd < 0) {
+                errors[k] = string("accept 失败: ") + strerror(errno);
+                return;
+            }
+            receivers.emplace_back([&, fd, k]() {
+                try {
+                    // 只追加完整的元素，余下的字节留到下次
+                    vector<char> buffer(SHUFFLE_BATCH);
+                    size_t filled = 0;
+                    while (true) {
+                        ssize_t r = recv(fd, buffer.data() + filled, buffer.size() - filled, 0);
+                        if (r < 0 && errno == EINTR) continue;
+                        if (r < 0) throw runtime_error(string("接收失败: ") + strerror(errno));
+                        if (r == 0) break;
+                        filled += r;
+                        bytesReceived += r;
+                        size_t whole = filled / sizeof(T) * sizeof(T);
+                        appendReceived(buffer.data(), whole);
+                        memmove(buffer.data(), buffer.data() + whole, filled - whole);
+                        filled -= whole;
+                    }
+                    if (filled != 0) {
+                        throw runtime_error("收到不完整的元素");
+                    }
+                } catch (const exception& e) {
+                    errors[k] = e.what();
+                }
+                close(fd);
+            });
+        }
+    });
+
+    vector<int> peers(workerCount, -1);
+    vector<vector<T>> outgoing(workerCount);
+    try {
+        for (int j = 0; j < workerCount; j++) {
+            if (j != id) peers[j] = connectSocket(socketPaths[j]);
+            outgoing[j].reserve(SHUFFLE_BATCH / sizeof(T));
+        }
+
+        auto flushTo = [&](int j) {
+            const char* data = reinterpret_cast<const char*>(outgoing[j].data());
+            size_t n = outgoing[j].size() * sizeof(T);
+            if (j == id) {
+                appendReceived(data, n);
+            } else {
+                sendAll(peers[j], data, n);
+                stats.bytesSent += n;
+            }
+            outgoing[j].clear();
+        };
+
+        vector<T> chunk(COPY_BLOCK / sizeof(T));
+        for (uint64_t pos = begin; pos < end; ) {
+            size_t n = min<uint64_t>(chunk.size(), end - pos);
+            preadAll(inFd, chunk.data(), n * sizeof(T), base + pos * sizeof(T));
+            for (size_t i = 0; i < n; i++) {
+                int j = upper_bound(splitters.begin(), splitters.end(), chunk[i]) - splitters.begin();
+                outgoing[j].push_back(chunk[i]);
+                if (outgoing[j].size() * sizeof(T) >= SHUFFLE_BATCH) {
+                    flushTo(j);
+                }
+            }
+            pos += n;
+        }
+        for (int j = 0; j < workerCount; j++) {
+            flushTo(j);
+        }
+    } catch (...) {
+        // 关闭连接让对端的接收线程结束，再交给协调进程处理
+        for (int fd : peers) {
+            if (fd >= 0) close(fd);
+        }
+        shutdown(listenFd, SHUT_RDWR);
+        acceptor.join();
+        for (auto& receiver : receivers) receiver.join();
+        throw;
+    }
+
+    // 发送完毕：关闭写端，对端读到 EOF
+    for (int fd : peers) {
+        if (fd >= 0) {
+            shutdown(fd, SHUT_WR);
+            close(fd);
+        }
+    }
+    acceptor.join();
+    for (auto& receiver : receivers) receiver.join();
+    for (const auto& error : errors) {
+        if (!error.empty()) throw runtime_error(error);
+    }
+    close(receivedFd);
+    close(inFd);
+
+    stats.bytesReceived = bytesReceived;
+    stats.diskBytes += receivedOffset;
+    stats.shuffleSeconds = secondsSince(phaseStart);
+
+    // 3. 本地外排序（溢写放在任务目录下，进度信息不输出；任务目录排序后即删除，
+    // 断点续排的检查点没有意义）
+    phaseStart = chrono::steady_clock::now();
+    string sortedFile = jobDir + "/sorted_" + to_string(id) + ".dat";
+    ostream quiet(nullptr);
+    ExternalSort::setProgressStream(quiet);
+    ExternalSort::setTempDirectories({jobDir});
+    ExternalSort::setMergeOutput(MergeOutputMode::ALL);
+    ExternalSort::setResumable(false);
+    localSort(receivedFile, sortedFile);
+    remove(receivedFile.c_str());
+
+    uint64_t sortedBytes = FileUtils::getFileSize(sortedFile);
+    stats.elements = sortedBytes / sizeof(T);
+    stats.diskBytes += ExternalSort::getLastStats().spillBytes + sortedBytes;
+    stats.sortSeconds = secondsSince(phaseStart);
+
+    sendMessage(control, MSG_COUNT, &stats.elements, sizeof(stats.elements));
+    expectMessage(control, MSG_OFFSET, payload);
+    uint64_t outputOffset;
+    memcpy(&outputOffset, payload.data(), sizeof(outputOffset));
+
+    // 4. 把有序区间写到输出文件中属于本进程的位置
+    phaseStart = chrono::steady_clock::now();
+    int sortedFd = open(sortedFile.c_str(), O_RDONLY);
+    int outFd = open(outputFile.c_str(), O_WRONLY);
+    if (sortedFd < 0 || outFd < 0) {
+        throw runtime_error("无法打开输出文件: " + outputFile);
+    }
+    vector<char> block(COPY_BLOCK);
+    for (uint64_t done = 0; done < sortedBytes; ) {
+        size_t n = min<uint64_t>(block.size(), sortedBytes - done);
+        preadAll(sortedFd, block.data(), n, done);
+        pwriteAll(outFd, block.data(), n, base + outputOffset * sizeof(T) + done);
+        done += n;
+    }
+    if (fsync(outFd) != 0 || close(outFd) != 0) {
+        throw runtime_error("写入输出文件失败: " + outputFile);
+    }
+    close(sortedFd);
+    remove(sortedFile.c_str());
+
+    stats.diskBytes += sortedBytes;
+    stats.writeSeconds = secondsSince(phaseStart);
+    return stats;
+}
+
+#endif
+
+} // namespace
+
+template<typename T>
+void DistributedSort::sortFile(const string& inputFile, const string& outputFile,
+                               int workerCount, const string& typeName,
+                               void (*localSort)(const string&, const string&)) {
+#ifdef _WIN32
+    throw runtime_error("分布式排序需要 POSIX 系统（fork 与 Unix 套接字）");
+#else
+    if (workerCount < 1) {
+        throw runtime_error("工作进程数必须大于 0");
+    }
+    // 各区间的元素数决定输出偏移，去重/计数输出会改变元素数与输出格式
+    if (ExternalSort::getMergeOutput() != MergeOutputMode::ALL) {
+        throw runtime_error("分布式排序只支持输出全部元素（不支持去重/计数输出）");
+    }
+    int64_t inputSize = FileUtils::getFileSize(inputFile);
+    if (inputSize < 0) {
+        throw runtime_error("无法打开输入文件: " + inputFile);
+    }
+    DataFileHeader header;
+    bool headered = FileUtils::readDataHeader(inputFile, header, DataFileHeader::typeOf<T>());
+    uint64_t base = headered ? sizeof(DataFileHeader) : 0;
+    uint64_t total = (inputSize - base) / sizeof(T);
+
+    cout << "开始分布式排序 (" << typeName << ", " << workerCount << " 个工作进程): "
+         << inputFile << " -> " << outputFile << endl;
+
+    lastStats = DistributedSortStats();
+    lastStats.workerCount = workerCount;
+
+    string jobDir = "temp_distributed_" + to_string(getpid()) + "_" + to_string(time(nullptr));
+    if (!FileUtils::createDirectory(jobDir)) {
+        throw runtime_error("无法创建临时目录: " + jobDir);
+    }
+
+    // 输出文件预先设好大小，各工作进程按偏移写入自己的区间
+    int outFd = open(outputFile.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (outFd < 0 || ftruncate(outFd, base + total * sizeof(T)) != 0) {
+        if (outFd >= 0) close(outFd);
+        rmdir(jobDir.c_str());
+        throw runtime_error("无法创建输出文件: " + outputFile);
+    }
+    close(outFd);
+
+    // 监听套接字在 fork 前建好，工作进程之间连接时无需等待
+    vector<string> socketPaths;
+    vector<int> listeners;
+    vector<int> controls;
+    vector<pid_t> pids;
+
+    auto cleanup = [&]() {
+        for (int fd : listeners) close(fd);
+        for (int fd : controls) close(fd);
+        for (const auto& path : socketPaths) unlink(path.c_str());
+        for (int i = 0; i < workerCount; i++) {
+            remove((jobDir + "/received_" + to_string(i) + ".dat").c_str());
+            remove((jobDir + "/sorted_" + to_string(i) + ".dat").c_str());
+        }
+        rmdir(jobDir.c_str());
+    };
+
+    try {
+        for (int i = 0; i < workerCount; i++) {
+            socketPaths.push_back(jobDir + "/worker_" + to_string(i) + ".sock");
+            listeners.push_back(listenSocket(socketPaths.back()));
+        }
+
+        cout.flush();
+        for (int i = 0; i < workerCount; i++) {
+            int pair[2];
+            if (socketpair(AF_UNIX, SOCK_STREAM, 0, pair) != 0) {
+                throw runtime_error(string("socketpair 失败: ") + strerror(errno));
+            }
+            pid_t pid = fork();
+            if (pid < 0) {
+                close(pair[0]);
+                close(pair[1]);
+                throw runtime_error(string("fork 失败: ") + strerror(errno));
+            }
+            if (pid == 0) {
+                // 工作进程：只保留自己的监听套接字与控制连接
+                close(pair[0]);
+                for (int fd : controls) close(fd);
+                for (int j = 0; j < workerCount; j++) {
+                    if (j != i) close(listeners[j]);
+                }
+                int status = 0;
+                try {
+                    DistributedWorkerStats stats = runWorker<T>(i, workerCount, inputFile, outputFile, jobDir,
+                                                                socketPaths, listeners[i], pair[1],
+                                                                samplesPerWorker, localSort);
+                    sendMessage(pair[1], MSG_REPORT, &stats, sizeof(stats));
+                } catch (const exception& e) {
+                    string message = e.what();
+                    try {
+                        sendMessage(pair[1], MSG_ERROR, message.data(), message.size());
+                    } catch (...) {
+                    }
+                    status = 1;
+                }
+                _exit(status);
+            }
+            close(pair[1]);
+            controls.push_back(pair[0]);
+            pids.push_back(pid);
+        }
+
+        // 阶段1：汇总采样，等距选取 N-1 个分割点
+        auto phaseStart = chrono::steady_clock::now();
+        vector<T> samples;
+        for (const auto& payload : gatherMessages(controls, MSG_SAMPLES)) {
+            const T* values = reinterpret_cast<const T*>(payload.data());
+            samples.insert(samples.end(), values, values + payload.size() / sizeof(T));
+        }
+        sort(samples.begin(), samples.end());
+        vector<T> splitters;
+        for (int k = 1; k < workerCount && !samples.empty(); k++) {
+            splitters.push_back(samples[samples.size() * k / workerCount]);
+        }
+        for (int fd : controls) {
+            sendMessage(fd, MSG_SPLITTERS, splitters.data(), splitters.size() * sizeof(T));
+        }
+        lastStats.samplePhaseSeconds = secondsSince(phaseStart);
+
+        // 阶段2/3：洗牌与本地排序完成后，按区间大小计算输出偏移
+        uint64_t offset = 0;
+        vector<vector<char>> counts = gatherMessages(controls, MSG_COUNT);
+        for (size_t i = 0; i < controls.size(); i++) {
+            uint64_t count;
+            memcpy(&count, counts[i].data(), sizeof(count));
+            sendMessage(controls[i], MSG_OFFSET, &offset, sizeof(offset));
+            offset += count;
+        }
+        if (offset != total) {
+            throw runtime_error("工作进程输出的元素数与输入不一致");
+        }
+
+        // 阶段4：各进程写入自己的区间后上报统计
+        for (const auto& payload : gatherMessages(controls, MSG_REPORT)) {
+            DistributedWorkerStats stats;
+            memcpy(&stats, payload.data(), sizeof(stats));
+            lastStats.workers.push_back(stats);
+        }
+
+        for (pid_t pid : pids) {
+            int status = 0;
+            waitpid(pid, &status, 0);
+        }
+        pids.clear();
+
+    } catch (...) {
+        for (pid_t pid : pids) {
+            kill(pid, SIGKILL);
+            waitpid(pid, nullptr, 0);
+        }
+        cleanup();
+        throw;
+    }
+    cleanup();
+
+    // 输出是输入的一个排列：文件头只需标记为有序
+    if (headered) {
+        header.flags |= DATA_FLAG_SORTED;
+        FileUtils::writeDataHeader(outputFile, header);
+    }
+
+    // 汇总：各阶段以最慢的工作进程为准
+    for (const auto& worker : lastStats.workers) {
+        lastStats.shufflePhaseSeconds = max(lastStats.shufflePhaseSeconds, worker.shuffleSeconds);
+        lastStats.sortPhaseSeconds = max(lastStats.sortPhaseSeconds, worker.sortSeconds);
+        lastStats.writePhaseSeconds = max(lastStats.writePhaseSeconds, worker.writeSeconds);
+        lastStats.networkBytes += worker.bytesSent;
+        lastStats.diskBytes += worker.diskBytes;
+    }
+    const double MB = 1024.0 * 1024.0;
+    if (lastStats.shufflePhaseSeconds > 0) {
+        lastStats.networkMBps = lastStats.networkBytes / MB / lastStats.shufflePhaseSeconds;
+    }
+    double diskSeconds = lastStats.shufflePhaseSeconds + lastStats.sortPhaseSeconds + lastStats.writePhaseSeconds;
+    if (diskSeconds > 0) {
+        lastStats.diskMBps = lastStats.diskBytes / MB / diskSeconds;
+    }
+
+    cout << "分布式排序完成: " << outputFile << endl;
+#endif
+}
+
+void DistributedSort::sortIntegerFile(const string& inputFile, const string& outputFile, int workerCount) {
+    sortFile<int64_t>(inputFile, outputFile, workerCount, "整数", ExternalSort::sortIntegerFile);
+}
+
+void DistributedSort::sortDoubleFile(const string& inputFile, const string& outputFile, int workerCount) {
+    sortFile<double>(inputFile, outputFile, workerCount, "浮点数", ExternalSort::sortDoubleFile);
+}
+
+void DistributedSort::printStats() {
+    const double MB = 1024.0 * 1024.0;
+    cout << fixed << setprecision(3);
+    cout << "工作进程数: " << lastStats.workerCount << endl;
+    cout << "采样阶段: " << lastStats.samplePhaseSeconds << " 秒" << endl;
+    cout << "洗牌阶段: " << lastStats.shufflePhaseSeconds << " 秒, 网络 "
+         << lastStats.networkBytes / MB << " MB (" << lastStats.networkMBps << " MB/s)" << endl;
+    cout << "排序阶段: " << lastStats.sortPhaseSeconds << " 秒" << endl;
+    cout << "写出阶段: " << lastStats.writePhaseSeconds << " 秒" << endl;
+    cout << "磁盘写入: " << lastStats.diskBytes / MB << " MB (" << lastStats.diskMBps << " MB/s)" << endl;
+    for (size_t i = 0; i < lastStats.workers.size(); i++) {
+        const auto& worker = lastStats.workers[i];
+        cout << "  进程 " << i << ": " << worker.elements << " 个元素, 发送 "
+             << worker.bytesSent / MB << " MB, 接收 " << worker.bytesReceived / MB << " MB, 洗牌 "
+             << worker.shuffleSeconds << " 秒, 排序 " << worker.sortSeconds << " 秒, 写出 "
+             << worker.writeSeconds << " 秒" << endl;
+    }
+}
@@ -1,8 +1,12 @@
 #include "external_sort.h"
 #include "data_generator.h"
 #include "file_utils.h"
+#include "direct_io.h"
+#include "memory_monitor.h"
+#include "string_column.h"
 #include <fstream>
 #include <iostream>
+#include <sstream>
 #include <algorithm>
 #include <queue>
 #include <vector>
@@ -10,17 +14,101 @@
 #include <sys/stat.h>
 #include <cstdlib>
 #include <ctime>
+#include <cstring>
+#include <thread>
+#include <chrono>
+#include <future>
+#include <atomic>
 
 #ifdef _WIN32
 #include <direct.h>
+#include <process.h>
 #else
 #include <unistd.h>
+#include <fcntl.h>
+#include <cerrno>
+#include <sys/mman.h>
+#include <sys/resource.h>
 #endif
 
 using namespace std;
 
 // initialize static member variable
 size_t ExternalSort::memoryLimit = 100 * 1024 * 1024; // default 100MB
+unsigned ExternalSort::threadCount = 0;                // 0 = hardware concurrency
+RunCodecType ExternalSort::runCodec = RunCodecType::NONE;
+InputReadMode ExternalSort::inputMode = InputReadMode::STREAM;
+bool ExternalSort::directIO = false;
+vector<string> ExternalSort::tempRoots = {"."};
+TempPlacement ExternalSort::tempPlacement = TempPlacement::ROUND_ROBIN;
+vector<int64_t> ExternalSort::jobFreeSpace;
+bool ExternalSort::autoMemory = false;
+size_t ExternalSort::maxFanIn = 0;                    // 0 = merge all runs at once
+bool ExternalSort::detectPresorted = true;
+MergeOutputMode ExternalSort::mergeOutput = MergeOutputMode::ALL;
+ostream* ExternalSort::progressOut = &cout;
+bool ExternalSort::verifyOutput = false;
+bool ExternalSort::resumable = false;
+SortCheckpoint ExternalSort::checkpoint;
+uint64_t ExternalSort::inputOffset = 0;
+uint64_t ExternalSort::outputOffset = 0;
+ExternalSortStats ExternalSort::lastStats;
+
+unsigned ExternalSort::getThreadCount() {
+    if (threadCount > 0) return threadCount;
+    unsigned hw = thread::hardware_concurrency();
+    return hw > 0 ? hw : 1;
+}
+
+// auto mode: derive the budget from the memory this process could still
+// claim (MemAvailable, capped by the cgroup headroom) plus what the job
+// already holds; during a job the budget only ever shrinks
+size_t ExternalSort::refreshMemoryBudget(size_t heldBytes, bool shrinkOnly) {
+    if (!autoMemory) return memoryLimit;
+
+    const size_t MIN_BUDGET = 16 * 1024 * 1024;
+
+    size_t available = MemoryMonitor::getAvailableSystemMemory();
+    size_t headroom = MemoryMonitor::getCgroupMemoryHeadroom();
+    if (available == 0 && headroom == SIZE_MAX) return memoryLimit;  // nothing to go on
+    if (available == 0 || headroom < available) available = headroom;
+
+    // half for run buffers, the rest covers sort scratch space and page cache
+    size_t budget = max(MIN_BUDGET, (available + heldBytes) / 2);
+
+    if (!shrinkOnly) {
+        memoryLimit = budget;
+    } else if (budget < memoryLimit / 10 * 9) {
+        // ignore small fluctuations so the run size doesn't churn
+        memoryLimit = budget;
+    }
+    return memoryLimit;
+}
+
+// how many runs one merge may read at once (0 = no limit): always well inside
+// the open file limit, since every run (natural runs included) holds its own
+// descriptors; auto mode also keeps every reader buffer at least MIN_READ_BUFFER
+size_t ExternalSort::getMergeFanIn() {
+    size_t fanIn = maxFanIn > 0 ? max<size_t>(2, maxFanIn) : 0;
+    auto cap = [&fanIn](size_t limit) {
+        fanIn = fanIn == 0 ? limit : min(fanIn, limit);
+    };
+
+    if (autoMemory) {
+        const size_t MIN_READ_BUFFER = 256 * 1024;
+        cap(max<size_t>(2, memoryLimit / 2 / MIN_READ_BUFFER));
+    }
+
+#ifndef _WIN32
+    // a direct-I/O run keeps two descriptors open
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY) {
+        size_t fdBudget = limit.rlim_cur > 64 ? (limit.rlim_cur - 32) / 2 : 2;
+        cap(max<size_t>(2, fdBudget));
+    }
+#endif
+    return fanIn;
+}
 
 // create temporary directory
 bool createTempDirectory(const string& dir) {
@@ -31,6 +119,112 @@ bool createTempDirectory(const string& dir) {
 #endif
 }
 
+// create this job's spill directory under every temp root; the name carries
+// the pid and a per-process sequence number so concurrent jobs never collide.
+// A resumable job uses a fixed name instead, so a rerun finds its checkpoint.
+vector<string> ExternalSort::createJobDirectories(const string& tempTag, const string& resumeKey) {
+    static atomic<unsigned> jobSequence(0);
+
+#ifdef _WIN32
+    int pid = _getpid();
+#else
+    int pid = getpid();
+#endif
+    string jobName = "temp_external_" + tempTag + "_" + to_string(time(nullptr)) + "_"
+                   + to_string(pid) + "_" + to_string(jobSequence++);
+    if (!resumeKey.empty()) {
+        jobName = "temp_external_" + tempTag + "_resume_" + resumeKey;
+    }
+
+    vector<string> dirs;
+    for (const auto& root : tempRoots) {
+        string dir = root.empty() || root == "." ? jobName : root + "/" + jobName;
+        bool reused = !resumeKey.empty() && FileUtils::directoryExists(dir);
+        if (!reused && !createTempDirectory(dir)) {
+            removeJobDirectories(dirs);
+            throw runtime_error("Cannot create temporary directory: " + dir);
+        }
+        dirs.push_back(dir);
+    }
+
+    // remember the free space of every device for free-space placement
+    jobFreeSpace.clear();
+    for (const auto& dir : dirs) {
+        jobFreeSpace.push_back(max<int64_t>(0, FileUtils::getAvailableSpace(dir)));
+    }
+    return dirs;
+}
+
+// remove this job's spill directories and everything left in them
+void ExternalSort::removeJobDirectories(const vector<string>& dirs) {
+    for (const auto& dir : dirs) {
+        FileUtils::cleanDirectory(dir);
+        rmdir(dir.c_str());
+    }
+}
+
+// pick the spill directory for the next run
+size_t ExternalSort::pickTempDirectory(size_t runIndex, uint64_t runBytes, size_t dirCount) {
+    if (dirCount <= 1) return 0;
+
+    if (tempPlacement == TempPlacement::ROUND_ROBIN || jobFreeSpace.size() != dirCount) {
+        return runIndex % dirCount;
+    }
+
+    size_t best = 0;
+    for (size_t d = 1; d < dirCount; d++) {
+        if (jobFreeSpace[d] > jobFreeSpace[best]) best = d;
+    }
+    jobFreeSpace[best] -= min<int64_t>(jobFreeSpace[best], runBytes);
+    return best;
+}
+
+// the pairwise merges borrow a temporary buffer of up to half the run
+size_t ExternalSort::sortScratchBytes(size_t elementBytes) {
+    return getThreadCount() > 1 ? (elementBytes + 1) / 2 : 0;
+}
+
+// sort a run buffer: one slice per worker thread, then pairwise merges
+template<typename T, typename Compare>
+void ExternalSort::parallelSort(T* data, size_t count, Compare comp) {
+    const size_t MIN_SLICE = 1 << 16;
+
+    size_t threads = getThreadCount();
+    threads = min(threads, max<size_t>(1, count / MIN_SLICE));
+    if (threads <= 1) {
+        sort(data, data + count, comp);
+        return;
+    }
+
+    // slice boundaries
+    vector<size_t> bounds(threads + 1);
+    for (size_t t = 0; t <= threads; t++) {
+        bounds[t] = count * t / threads;
+    }
+
+    vector<thread> workers;
+    for (size_t t = 0; t < threads; t++) {
+        workers.emplace_back([data, &bounds, comp, t]() {
+            sort(data + bounds[t], data + bounds[t + 1], comp);
+        });
+    }
+    for (auto& worker : workers) worker.join();
+
+    // merge neighbouring slices, doubling the width every round
+    for (size_t width = 1; width < threads; width *= 2) {
+        workers.clear();
+        for (size_t t = 0; t + width < threads; t += 2 * width) {
+            size_t first = bounds[t];
+            size_t middle = bounds[t + width];
+            size_t last = bounds[min(t + 2 * width, threads)];
+            workers.emplace_back([data, comp, first, middle, last]() {
+                inplace_merge(data + first, data + middle, data + last, comp);
+            });
+        }
+        for (auto& worker : workers) worker.join();
+    }
+}
+
 // read a chunk of data
 template<typename T>
 vector<T> ExternalSort::readChunk(const string& filename, size_t chunkSize) {
@@ -56,286 +250,2297 @@ vector<T> ExternalSort::readChunk(const string& filename, size_t chunkSize) {
     return data;
 }
 
-// write a chunk of data
+namespace {
+
+const size_t RUN_BLOCK = RunCodec::BLOCK_ELEMENTS;
+
+// size of the byte buffer a run writer accumulates before writing
+const size_t RUN_WRITE_BUFFER = 1 << 20;
+
+// element hashes for the verification multiset hashes (splitmix64 finalizer)
+uint64_t mixHash(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
 template<typename T>
-void ExternalSort::writeChunk(const string& filename, const vector<T>& data) {
-    ofstream outFile(filename, ios::binary);
-    if (!outFile) {
-        throw runtime_error("Cannot open file: " + filename);
+uint64_t elementHash(const T& value) {
+    return mixHash(RunCodec::toKey(value));
+}
+
+uint64_t stringHash(string_view value) {
+    uint64_t hash = 0xcbf29ce484222325ULL; // FNV-1a
+    for (unsigned char c : value) {
+        hash = (hash ^ c) * 0x100000001b3ULL;
     }
+    return mixHash(hash);
+}
 
-    outFile.write(reinterpret_cast<const char*>(data.data()),
-                 data.size() * sizeof(T));
-    outFile.close();
+// order-sensitive checksum of a byte stream; the words are mixed with their
+// position, so the value does not depend on how the stream was chunked
+class StreamChecksum {
+public:
+    void update(const char* data, size_t n) {
+        length += n;
+        while (n > 0 && tailBytes != 0) {
+            tail[tailBytes++] = *data++;
+            n--;
+            if (tailBytes == sizeof(tail)) {
+                addWord(tail);
+                tailBytes = 0;
+            }
+        }
+        for (; n >= sizeof(tail); data += sizeof(tail), n -= sizeof(tail)) {
+            addWord(data);
+        }
+        if (n > 0) {
+            memcpy(tail, data, n);
+            tailBytes = n;
+        }
+    }
+
+    uint64_t value() const {
+        uint64_t result = sum;
+        if (tailBytes != 0) {
+            char last[8] = {};
+            memcpy(last, tail, tailBytes);
+            uint64_t word;
+            memcpy(&word, last, sizeof(word));
+            result += mixHash(word ^ (words * 0x9e3779b97f4a7c15ULL));
+        }
+        return mixHash(result + length);
+    }
+
+private:
+    uint64_t sum = 0;
+    uint64_t words = 0;
+    uint64_t length = 0;
+    char tail[8];
+    size_t tailBytes = 0;
+
+    void addWord(const char* p) {
+        uint64_t word;
+        memcpy(&word, p, sizeof(word));
+        sum += mixHash(word ^ (words++ * 0x9e3779b97f4a7c15ULL));
+    }
+};
+
+// checksum of bytes [offset, offset + bytes) of a file, or 0 if it is shorter
+uint64_t fileChecksum(const string& path, uint64_t offset, uint64_t bytes) {
+    ifstream in(path, ios::binary);
+    in.seekg(offset);
+    vector<char> buffer(RUN_WRITE_BUFFER);
+    StreamChecksum checksum;
+    while (bytes > 0 && in) {
+        in.read(buffer.data(), min<uint64_t>(buffer.size(), bytes));
+        checksum.update(buffer.data(), in.gcount());
+        bytes -= in.gcount();
+    }
+    return bytes == 0 ? checksum.value() : 0;
 }
 
-// create initial sorted runs
+// the block index of a checkpointed run lives next to it: block count,
+// offsets, first keys and a checksum of the three
+void saveRunIndex(const RunInfo& run) {
+    uint64_t blocks = run.blockOffsets.size();
+    StreamChecksum checksum;
+    checksum.update(reinterpret_cast<const char*>(&blocks), sizeof(blocks));
+    checksum.update(reinterpret_cast<const char*>(run.blockOffsets.data()), blocks * sizeof(uint64_t));
+    checksum.update(reinterpret_cast<const char*>(run.blockFirstKeys.data()), blocks * sizeof(uint64_t));
+    uint64_t value = checksum.value();
+
+    ofstream out(run.path + ".idx", ios::binary);
+    out.write(reinterpret_cast<const char*>(&blocks), sizeof(blocks));
+    out.write(reinterpret_cast<const char*>(run.blockOffsets.data()), blocks * sizeof(uint64_t));
+    out.write(reinterpret_cast<const char*>(run.blockFirstKeys.data()), blocks * sizeof(uint64_t));
+    out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    if (!out.flush()) {
+        throw runtime_error("Cannot write run index: " + run.path + ".idx");
+    }
+}
+
+bool loadRunIndex(RunInfo& run) {
+    ifstream in(run.path + ".idx", ios::binary);
+    uint64_t blocks = 0;
+    if (!in.read(reinterpret_cast<char*>(&blocks), sizeof(blocks)) ||
+        blocks != (run.count + RUN_BLOCK - 1) / RUN_BLOCK) {
+        return false;
+    }
+    run.blockOffsets.resize(blocks);
+    run.blockFirstKeys.resize(blocks);
+    uint64_t stored = 0;
+    in.read(reinterpret_cast<char*>(run.blockOffsets.data()), blocks * sizeof(uint64_t));
+    in.read(reinterpret_cast<char*>(run.blockFirstKeys.data()), blocks * sizeof(uint64_t));
+    in.read(reinterpret_cast<char*>(&stored), sizeof(stored));
+    if (!in) return false;
+
+    StreamChecksum checksum;
+    checksum.update(reinterpret_cast<const char*>(&blocks), sizeof(blocks));
+    checksum.update(reinterpret_cast<const char*>(run.blockOffsets.data()), blocks * sizeof(uint64_t));
+    checksum.update(reinterpret_cast<const char*>(run.blockFirstKeys.data()), blocks * sizeof(uint64_t));
+    return checksum.value() == stored;
+}
+
+// order check and output hash of one stream of merged values
 template<typename T>
-int ExternalSort::createInitialRuns(const string& inputFile,
-                                  const string& tempDir,
-                                  bool (*compare)(const T&, const T&)) {
+struct OutputCheck {
+    MultisetHash hash;
+    bool ordered = true;
+    bool any = false;
+    T first{};
+    T last{};
+
+    template<typename Less>
+    void add(const T& value, uint64_t count, Less less) {
+        if (!any) {
+            first = value;
+            any = true;
+        } else if (less(value, last)) {
+            ordered = false;
+        }
+        last = value;
+        hash.add(elementHash(value), count);
+    }
+};
 
-    ifstream inFile(inputFile, ios::binary | ios::ate);
-    if (!inFile) {
-        throw runtime_error("Cannot open input file: " + inputFile);
+
+// streaming writer for a sorted run, raw or block-encoded; records the
+// sparse block index (first key and byte offset of every block) as it goes.
+// A counted run also writes the count of every value to a raw side file.
+template<typename T>
+class RunWriter {
+public:
+    RunWriter(const string& path, RunCodecType codec, bool direct, bool counted = false)
+        : outFile(path, true, direct), writer(outFile, 0), codec(codec) {
+        info.path = path;
+        info.codec = codec;
+        pending.reserve(RUN_BLOCK);
+        bytes.reserve(RUN_WRITE_BUFFER + RUN_BLOCK * 10 + RunCodec::HEADER_BYTES);
+        if (counted) {
+            info.countPath = path + ".cnt";
+            countFile = make_unique<DirectFile>(info.countPath, true, direct);
+            countWriter = make_unique<DirectFileWriter>(*countFile, 0);
+            counts.reserve(RUN_WRITE_BUFFER / sizeof(uint64_t));
+        }
     }
 
-    // get file size
-    size_t fileSize = inFile.tellg();
-    inFile.seekg(0, ios::beg);
+    void append(const T& value, uint64_t count) {
+        counts.push_back(count);
+        if (counts.size() * sizeof(uint64_t) >= RUN_WRITE_BUFFER) {
+            flushCounts();
+        }
+        append(value);
+    }
 
-    // calculate number of elements per run
-    size_t elementSize = sizeof(T);
-    size_t elementsPerRun = memoryLimit / elementSize;
+    void append(const T& value) {
+        pending.push_back(value);
+        if (pending.size() == RUN_BLOCK) {
+            flushBlock();
+        }
+    }
 
-    vector<T> buffer(elementsPerRun);
-    int runCount = 0;
+    void append(const T* data, size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            append(data[i]);
+        }
+    }
 
-    while (inFile) {
-        // read a batch of data
-        inFile.read(reinterpret_cast<char*>(buffer.data()),
-                   elementsPerRun * elementSize);
-        size_t bytesRead = inFile.gcount();
-        size_t elementsRead = bytesRead / elementSize;
+    RunInfo finish() {
+        if (!pending.empty()) {
+            flushBlock();
+        }
+        flushBytes();
+        writer.finish();
+        outFile.close();
+        if (countWriter) {
+            flushCounts();
+            countWriter->finish();
+            countFile->close();
+            info.countChecksum = countChecksum.value();
+        }
+        info.checksum = checksum.value();
+        return move(info);
+    }
 
-        if (elementsRead == 0) break;
+private:
+    DirectFile outFile;
+    DirectFileWriter writer;
+    RunCodecType codec;
+    RunInfo info;
+    vector<T> pending;
+    vector<uint64_t> keys;
+    vector<char> bytes;
+    unique_ptr<DirectFile> countFile;
+    unique_ptr<DirectFileWriter> countWriter;
+    vector<uint64_t> counts;
+    StreamChecksum checksum;
+    StreamChecksum countChecksum;
+
+    void flushCounts() {
+        countWriter->append(counts.data(), counts.size() * sizeof(uint64_t));
+        countChecksum.update(reinterpret_cast<const char*>(counts.data()), counts.size() * sizeof(uint64_t));
+        counts.clear();
+    }
 
-        // resize buffer
-        buffer.resize(elementsRead);
+    void flushBlock() {
+        info.blockOffsets.push_back(info.bytes + bytes.size());
+        info.blockFirstKeys.push_back(RunCodec::toKey(pending[0]));
 
-        // sort this batch
-        if (compare) {
-            sort(buffer.begin(), buffer.end(), compare);
+        if (codec == RunCodecType::NONE) {
+            const char* src = reinterpret_cast<const char*>(pending.data());
+            bytes.insert(bytes.end(), src, src + pending.size() * sizeof(T));
         } else {
-            sort(buffer.begin(), buffer.end());
+            keys.resize(pending.size());
+            for (size_t i = 0; i < pending.size(); i++) {
+                keys[i] = RunCodec::toKey(pending[i]);
+            }
+            RunCodec::encodeBlock(keys.data(), keys.size(), bytes);
         }
 
-        // write to temporary file
-        string runFile = tempDir + "/run_" + to_string(runCount++) + ".dat";
-        writeChunk<T>(runFile, buffer);
+        info.count += pending.size();
+        pending.clear();
 
-        cout << "Created run " << runCount << " (" << elementsRead << " elements)" << endl;
+        if (bytes.size() >= RUN_WRITE_BUFFER) {
+            flushBytes();
+        }
     }
 
-    inFile.close();
-    return runCount;
-}
+    void flushBytes() {
+        writer.append(bytes.data(), bytes.size());
+        checksum.update(bytes.data(), bytes.size());
+        info.bytes += bytes.size();
+        bytes.clear();
+    }
+};
 
-// multi-way merge
+// buffered reader over the element range [begin, end) of a run; encoded runs
+// are decoded a batch of whole blocks at a time
 template<typename T>
-void ExternalSort::mergeRuns(const vector<string>& runFiles,
-                           const string& outputFile,
-                           bool (*compare)(const T&, const T&)) {
-
-    int numRuns = runFiles.size();
-    if (numRuns == 0) return;
+class RunReader {
+public:
+    RunReader(DirectFile& file, const RunInfo& run, uint64_t begin, uint64_t end, size_t bufferElements)
+        : file(file), run(run), nextIndex(begin), end(end), pos(0), filled(0) {
+        bufferElements = max(RUN_BLOCK, bufferElements / RUN_BLOCK * RUN_BLOCK);
+        buffer.resize(bufferElements);
+        if (run.codec != RunCodecType::NONE) {
+            keys.resize(bufferElements);
+        }
+        if (!run.countPath.empty()) {
+            countFile = make_unique<DirectFile>(run.countPath, false, file.isDirect());
+            counts.resize(bufferElements);
+        }
+    }
 
-    // open all run files
-    vector<ifstream> runStreams(numRuns);
-    vector<bool> hasMore(numRuns, true);
-    vector<T> currentValues(numRuns);
+    bool next(T& out) {
+        if (pos == filled && !refill()) {
+            return false;
+        }
+        out = buffer[pos++];
+        return true;
+    }
 
-    for (int i = 0; i < numRuns; i++) {
-        runStreams[i].open(runFiles[i], ios::binary);
-        if (!runStreams[i]) {
-            throw runtime_error("Cannot open run file: " + runFiles[i]);
+    // value and its count (1 unless the run is counted)
+    bool next(T& out, uint64_t& count) {
+        if (pos == filled && !refill()) {
+            return false;
         }
+        count = countFile ? counts[pos] : 1;
+        out = buffer[pos++];
+        return true;
+    }
 
-        // read first value from each run
-        if (runStreams[i].read(reinterpret_cast<char*>(&currentValues[i]), sizeof(T))) {
-            hasMore[i] = true;
-        } else {
-            hasMore[i] = false;
+private:
+    DirectFile& file;
+    const RunInfo& run;
+    uint64_t nextIndex;
+    uint64_t end;
+    vector<T> buffer;
+    vector<uint64_t> keys;
+    vector<char> encoded;
+    unique_ptr<DirectFile> countFile;
+    vector<uint64_t> counts;
+    size_t pos;
+    size_t filled;
+
+    // counts of the elements [first, first + filled) now in the buffer
+    void readCounts(uint64_t first) {
+        if (countFile) {
+            countFile->readAt(counts.data(), filled * sizeof(uint64_t), first * sizeof(uint64_t));
         }
     }
 
-    // use min-heap for multi-way merge
-    using Element = pair<T, int>;
-    auto heapCompare = [compare](const Element& a, const Element& b) {
-        if (compare) {
-            return compare(b.first, a.first); // min-heap
-        } else {
-            return b.first < a.first;
+    bool refill() {
+        if (nextIndex >= end) return false;
+
+        if (run.codec == RunCodecType::NONE) {
+            filled = min<uint64_t>(buffer.size(), end - nextIndex);
+            file.readAt(buffer.data(), filled * sizeof(T), run.fileOffset + nextIndex * sizeof(T));
+            readCounts(nextIndex);
+            nextIndex += filled;
+            pos = 0;
+            return true;
         }
-    };
 
-    priority_queue<Element, vector<Element>, decltype(heapCompare)> minHeap(heapCompare);
+        // decode whole blocks, starting with the one holding nextIndex
+        size_t blockCount = run.blockOffsets.size();
+        size_t firstBlock = nextIndex / RUN_BLOCK;
+        size_t lastBlock = min<uint64_t>((end - 1) / RUN_BLOCK, firstBlock + buffer.size() / RUN_BLOCK - 1);
+        uint64_t from = run.blockOffsets[firstBlock];
+        uint64_t to = lastBlock + 1 < blockCount ? run.blockOffsets[lastBlock + 1] : run.bytes;
+
+        encoded.resize(to - from);
+        file.readAt(encoded.data(), encoded.size(), run.fileOffset + from);
+
+        const char* p = encoded.data();
+        size_t decoded = 0;
+        for (size_t b = firstBlock; b <= lastBlock; b++) {
+            uint32_t count = RunCodec::readHeader(p).count;
+            if (decoded + count > keys.size()) {
+                throw runtime_error("Corrupt run file: " + run.path);
+            }
+            p = RunCodec::decodeBlock(p, keys.data() + decoded);
+            decoded += count;
+        }
+        for (size_t i = 0; i < decoded; i++) {
+            RunCodec::fromKey(keys[i], buffer[i]);
+        }
 
-    for (int i = 0; i < numRuns; i++) {
-        if (hasMore[i]) {
-            minHeap.push({currentValues[i], i});
+        uint64_t blockStart = static_cast<uint64_t>(firstBlock) * RUN_BLOCK;
+        pos = nextIndex - blockStart;
+        filled = min<uint64_t>(decoded, end - blockStart);
+        readCounts(blockStart);
+        nextIndex = blockStart + filled;
+        return pos < filled;
+    }
+};
+
+} // namespace
+
+// sequential reader for Phase 1 input: an ifstream, mmap windows of the
+// input that are copied into the caller's reused run buffer, or a caller's
+// stream of unknown length (stdin, pipes)
+class InputChunkReader {
+public:
+    explicit InputChunkReader(istream& in)
+        : mode(InputReadMode::STREAM), source(&in), offset(0), fileSize(0), rejectHeader(true) {
+#ifndef _WIN32
+        fd = -1;
+#endif
+    }
+
+    InputChunkReader(const string& path, InputReadMode mode)
+        : mode(mode), source(&stream), offset(0), fileSize(0), rejectHeader(false) {
+#ifdef _WIN32
+        this->mode = InputReadMode::STREAM;
+#else
+        fd = -1;
+        if (mode == InputReadMode::MMAP) {
+            fd = open(path.c_str(), O_RDONLY);
+            if (fd < 0) {
+                throw runtime_error("Cannot open input file: " + path);
+            }
+            struct stat info;
+            if (fstat(fd, &info) != 0) {
+                close(fd);
+                throw runtime_error("Cannot stat input file: " + path);
+            }
+            fileSize = info.st_size;
+            pageSize = sysconf(_SC_PAGESIZE);
+            return;
+        }
+#endif
+        stream.open(path, ios::binary);
+        if (!stream) {
+            throw runtime_error("Cannot open input file: " + path);
         }
     }
 
-    // open output file
-    ofstream outFileStream(outputFile, ios::binary);
-    if (!outFileStream) {
-        throw runtime_error("Cannot open output file: " + outputFile);
+    ~InputChunkReader() {
+#ifndef _WIN32
+        if (fd >= 0) close(fd);
+#endif
     }
 
-    int outputCount = 0;
-    const int BATCH_SIZE = 100000;
-    vector<T> outputBuffer;
-    outputBuffer.reserve(BATCH_SIZE);
+    InputChunkReader(const InputChunkReader&) = delete;
+    InputChunkReader& operator=(const InputChunkReader&) = delete;
+
+    // continue from byte position (a resumed job skips the input that is
+    // already in checkpointed runs)
+    void seek(uint64_t position) {
+        if (mode == InputReadMode::STREAM) {
+            source->seekg(position);
+            if (!*source) {
+                throw runtime_error("Cannot seek input to byte " + to_string(position));
+            }
+            return;
+        }
+        offset = position;
+    }
 
-    while (!minHeap.empty()) {
-        auto [value, runIndex] = minHeap.top();
-        minHeap.pop();
+    // read up to maxBytes into dst, returns 0 at end of input
+    size_t read(char* dst, size_t maxBytes) {
+        if (mode == InputReadMode::STREAM) {
+            source->read(dst, maxBytes);
+            size_t bytes = source->gcount();
+            // a caller's stream cannot seek past a data file header, and
+            // sorting the header as elements would corrupt the output
+            if (rejectHeader) {
+                rejectHeader = false;
+                if (bytes >= sizeof(DataFileHeader::MAGIC) &&
+                    memcmp(dst, DataFileHeader::MAGIC, sizeof(DataFileHeader::MAGIC)) == 0) {
+                    throw runtime_error("Input stream starts with a data file header; "
+                                        "pass the file by name instead");
+                }
+            }
+            return bytes;
+        }
+#ifdef _WIN32
+        return 0;
+#else
+        if (offset >= fileSize) return 0;
+        size_t bytes = min<uint64_t>(maxBytes, fileSize - offset);
 
-        // add to output buffer
-        outputBuffer.push_back(value);
-        outputCount++;
+        // mappings must start on a page boundary
+        uint64_t mapStart = offset / pageSize * pageSize;
+        size_t lead = offset - mapStart;
+        size_t mapLength = lead + bytes;
 
-        // if buffer is full, write to file
-        if (outputBuffer.size() >= BATCH_SIZE) {
-            outFileStream.write(reinterpret_cast<const char*>(outputBuffer.data()),
-                              outputBuffer.size() * sizeof(T));
-            outputBuffer.clear();
+        void* window = mmap(nullptr, mapLength, PROT_READ, MAP_PRIVATE, fd, mapStart);
+        if (window == MAP_FAILED) {
+            throw runtime_error(string("mmap failed: ") + strerror(errno));
         }
+        madvise(window, mapLength, MADV_SEQUENTIAL);
+        memcpy(dst, static_cast<char*>(window) + lead, bytes);
+        madvise(window, mapLength, MADV_DONTNEED);
+        munmap(window, mapLength);
 
-        // read next value from the same run
-        if (runStreams[runIndex].read(reinterpret_cast<char*>(&currentValues[runIndex]), sizeof(T))) {
-            minHeap.push({currentValues[runIndex], runIndex});
+        offset += bytes;
+        return bytes;
+#endif
+    }
+
+private:
+    InputReadMode mode;
+    ifstream stream;
+    istream* source;
+    uint64_t offset;
+    uint64_t fileSize;
+    bool rejectHeader;      // caller's stream: the first read checks for a header
+#ifndef _WIN32
+    int fd;
+    size_t pageSize;
+#endif
+};
+
+namespace {
+
+// first index of a sorted run whose element is not less than key: binary
+// search over the in-memory block index, then inside one decoded block
+template<typename T, typename Less>
+uint64_t lowerBoundInRun(DirectFile& file, const RunInfo& run, const T& key, Less less) {
+    size_t lo = 0, hi = run.blockFirstKeys.size();
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        T first;
+        RunCodec::fromKey(run.blockFirstKeys[mid], first);
+        if (less(first, key)) {
+            lo = mid + 1;
         } else {
-            hasMore[runIndex] = false;
+            hi = mid;
         }
     }
+    if (lo == 0) return 0;
 
-    // write remaining buffer contents
-    if (!outputBuffer.empty()) {
-        outFileStream.write(reinterpret_cast<const char*>(outputBuffer.data()),
-                          outputBuffer.size() * sizeof(T));
-    }
+    // the boundary lies inside block lo-1 or at the start of block lo
+    uint64_t blockStart = static_cast<uint64_t>(lo - 1) * RUN_BLOCK;
+    uint64_t blockEnd = min<uint64_t>(blockStart + RUN_BLOCK, run.count);
+    RunReader<T> reader(file, run, blockStart, blockEnd, RUN_BLOCK);
 
-    // close all files
-    for (auto& stream : runStreams) {
-        stream.close();
+    uint64_t index = blockStart;
+    T value;
+    while (reader.next(value) && less(value, key)) {
+        index++;
     }
-    outFileStream.close();
-
-    cout << "Merge completed, total " << outputCount << " elements output" << endl;
+    return index;
 }
 
-// sort integer file
-void ExternalSort::sortIntegerFile(const string& inputFile, const string& outputFile) {
-    cout << "Starting integer external sort: " << inputFile << " -> " << outputFile << endl;
+// k-way heap merge of the readers; every merged value is handed to
+// emit(value, count). With collapse, equal neighbours are emitted once with
+// their summed count. Returns the number of values emitted.
+template<typename T, typename Less, typename Emit>
+uint64_t heapMerge(vector<unique_ptr<RunReader<T>>>& readers, Less less, bool collapse, Emit emit) {
+    struct Element {
+        T value;
+        uint64_t count;
+        int run;
+    };
+    auto heapCompare = [&less](const Element& a, const Element& b) {
+        return less(b.value, a.value); // min-heap
+    };
+    priority_queue<Element, vector<Element>, decltype(heapCompare)> minHeap(heapCompare);
 
-    // create temporary directory
-    string tempDir = "temp_external_int_" + to_string(time(nullptr));
-    if (!createTempDirectory(tempDir)) {
-        throw runtime_error("Cannot create temporary directory: " + tempDir);
+    Element element;
+    for (size_t i = 0; i < readers.size(); i++) {
+        if (readers[i]->next(element.value, element.count)) {
+            element.run = i;
+            minHeap.push(element);
+        }
     }
 
-    vector<string> runFiles;
-    int runCount = 0;
+    uint64_t outputCount = 0;
+    bool havePending = false;
+    T pending{};
+    uint64_t pendingCount = 0;
 
-    try {
-        // Phase 1: create initial runs
-        cout << "Phase 1: Creating initial runs..." << endl;
-        runCount = createInitialRuns<int64_t>(inputFile, tempDir, compareInt);
+    while (!minHeap.empty()) {
+        element = minHeap.top();
+        minHeap.pop();
 
-        // collect run file list
-        for (int i = 0; i < runCount; i++) {
-            runFiles.push_back(tempDir + "/run_" + to_string(i) + ".dat");
+        if (!collapse) {
+            emit(element.value, element.count);
+            outputCount++;
+        } else if (havePending && !less(pending, element.value)) {
+            pendingCount += element.count;
+        } else {
+            if (havePending) {
+                emit(pending, pendingCount);
+                outputCount++;
+            }
+            pending = element.value;
+            pendingCount = element.count;
+            havePending = true;
         }
 
-        // Phase 2: multi-way merge
-        cout << "Phase 2: Multi-way merge (" << runCount << " runs)..." << endl;
-        mergeRuns<int64_t>(runFiles, outputFile, compareInt);
+        // read next value from the same run
+        if (readers[element.run]->next(element.value, element.count)) {
+            minHeap.push(element);
+        }
+    }
+
+    if (havePending) {
+        emit(pending, pendingCount);
+        outputCount++;
+    }
+    return outputCount;
+}
 
-        cout << "Integer external sort completed: " << outputFile << endl;
+// batches merge output into large writes handed to write(); with counts
+// every value is followed by its uint64 count
+template<typename T>
+class MergeOutput {
+public:
+    MergeOutput(const function<void(const char*, size_t)>& write, bool withCounts)
+        : write(write), withCounts(withCounts) {
+        batch.reserve(BATCH_BYTES + sizeof(T) + sizeof(uint64_t));
+    }
 
-    } catch (const exception& e) {
-        // cleanup temporary files
-        for (const auto& file : runFiles) {
-            remove(file.c_str());
+    void put(const T& value, uint64_t count) {
+        const char* p = reinterpret_cast<const char*>(&value);
+        batch.insert(batch.end(), p, p + sizeof(T));
+        if (withCounts) {
+            p = reinterpret_cast<const char*>(&count);
+            batch.insert(batch.end(), p, p + sizeof(uint64_t));
+        }
+        if (batch.size() >= BATCH_BYTES) {
+            flush();
         }
-        rmdir(tempDir.c_str());
-        throw;
     }
 
-    // cleanup temporary files
-    for (int i = 0; i < runCount; i++) {
-        string runFile = tempDir + "/run_" + to_string(i) + ".dat";
-        remove(runFile.c_str());
+    void flush() {
+        if (!batch.empty()) {
+            write(batch.data(), batch.size());
+        }
+        batch.clear();
+    }
+
+private:
+    static constexpr size_t BATCH_BYTES = 1 << 20;
+    const function<void(const char*, size_t)>& write;
+    bool withCounts;
+    vector<char> batch;
+};
+
+// collapse equal neighbours of a sorted buffer; counts (when given)
+// receives the multiplicity of every remaining value
+template<typename T, typename Less>
+void collapseSorted(vector<T>& data, vector<uint64_t>* counts, Less less) {
+    if (counts) counts->clear();
+    size_t out = 0;
+    for (size_t i = 0; i < data.size(); ) {
+        size_t j = i + 1;
+        while (j < data.size() && !less(data[i], data[j])) j++;
+        data[out++] = data[i];
+        if (counts) counts->push_back(j - i);
+        i = j;
     }
-    rmdir(tempDir.c_str());
+    data.resize(out);
 }
 
-// sort double file
-void ExternalSort::sortDoubleFile(const string& inputFile, const string& outputFile) {
-    cout << "Starting double external sort: " << inputFile << " -> " << outputFile << endl;
+// delete a temporary run together with its count file
+void removeRun(const RunInfo& run) {
+    if (!run.temporary) return;
+    remove(run.path.c_str());
+    remove((run.path + ".idx").c_str());
+    if (!run.countPath.empty()) remove(run.countPath.c_str());
+}
 
-    // create temporary directory
-    string tempDir = "temp_external_double_" + to_string(time(nullptr));
-    if (!createTempDirectory(tempDir)) {
-        throw runtime_error("Cannot create temporary directory: " + tempDir);
-    }
+// bytes a run occupies on disk
+uint64_t runDiskBytes(const RunInfo& run) {
+    return run.bytes + (run.countPath.empty() ? 0 : run.count * sizeof(uint64_t));
+}
 
-    vector<string> runFiles;
-    int runCount = 0;
+} // namespace
 
-    try {
-        // Phase 1: create initial runs
-        cout << "Phase 1: Creating initial runs..." << endl;
-        runCount = createInitialRuns<double>(inputFile, tempDir, compareDouble);
+// streaming pre-scan for presorted input: tracks the natural ascending runs
+// (with their block index) and whether the input is non-increasing, and
+// stops as soon as neither shortcut can apply, so random input costs only
+// its first few thousand elements
+template<typename T>
+PresortKind ExternalSort::scanPresorted(const string& inputFile, vector<RunInfo>& naturalRuns,
+                                        bool (*compare)(const T&, const T&)) {
+    auto less = [compare](const T& a, const T& b) {
+        return compare ? compare(a, b) : a < b;
+    };
 
-        // collect run file list
-        for (int i = 0; i < runCount; i++) {
-            runFiles.push_back(tempDir + "/run_" + to_string(i) + ".dat");
-        }
+    // more natural runs than this and a regular sort is the better deal
+    const size_t MAX_NATURAL_RUNS = 1024;
 
-        // Phase 2: multi-way merge
-        cout << "Phase 2: Multi-way merge (" << runCount << " runs)..." << endl;
-        mergeRuns<double>(runFiles, outputFile, compareDouble);
+    InputChunkReader inFile(inputFile, inputMode);
+    inFile.seek(inputOffset);
+    vector<T> buffer((1 << 20) / sizeof(T));
+    naturalRuns.clear();
 
-        cout << "Double external sort completed: " << outputFile << endl;
+    bool ascending = true;    // still within MAX_NATURAL_RUNS ascending runs
+    bool descending = true;   // no ascent seen so far
+    uint64_t index = 0;
+    T prev{};
 
-    } catch (const exception& e) {
-        // cleanup temporary files
-        for (const auto& file : runFiles) {
-            remove(file.c_str());
+    auto startRun = [&](uint64_t start) {
+        naturalRuns.emplace_back();
+        naturalRuns.back().path = inputFile;
+        naturalRuns.back().fileOffset = inputOffset + start * sizeof(T);
+        naturalRuns.back().temporary = false;
+    };
+
+    while (ascending || descending) {
+        size_t bytesRead = inFile.read(reinterpret_cast<char*>(buffer.data()), buffer.size() * sizeof(T));
+        size_t elementsRead = bytesRead / sizeof(T);
+        if (elementsRead == 0) break;
+
+        for (size_t i = 0; i < elementsRead && (ascending || descending); i++, index++) {
+            const T& value = buffer[i];
+            if (verifyOutput) {
+                lastStats.inputHash.add(elementHash(value));
+            }
+            if (index == 0) {
+                startRun(0);
+            } else if (less(value, prev)) {
+                if (ascending && naturalRuns.size() >= MAX_NATURAL_RUNS) {
+                    ascending = false;
+                    vector<RunInfo>().swap(naturalRuns);
+                } else if (ascending) {
+                    startRun(index);
+                }
+            } else if (less(prev, value)) {
+                descending = false;
+            }
+
+            if (ascending) {
+                RunInfo& run = naturalRuns.back();
+                if (run.count % RUN_BLOCK == 0) {
+                    run.blockOffsets.push_back(run.count * sizeof(T));
+                    run.blockFirstKeys.push_back(RunCodec::toKey(value));
+                }
+                run.count++;
+                run.bytes += sizeof(T);
+            }
+            prev = value;
         }
-        rmdir(tempDir.c_str());
-        throw;
     }
 
-    // cleanup temporary files
-    for (int i = 0; i < runCount; i++) {
-        string runFile = tempDir + "/run_" + to_string(i) + ".dat";
-        remove(runFile.c_str());
+    if (ascending && naturalRuns.size() <= 1) return PresortKind::SORTED;
+    if (descending) return PresortKind::REVERSED;
+    if (ascending) return PresortKind::NATURAL_RUNS;
+    return PresortKind::UNSORTED;
+}
+
+// copy presorted input to the output, reversing it back to front if asked
+template<typename T>
+void ExternalSort::copyInput(const string& inputFile, const string& outputFile, bool reverse) {
+    int64_t inputSize = FileUtils::getFileSize(inputFile);
+    if (inputSize < 0) {
+        throw runtime_error("Cannot open input file: " + inputFile);
+    }
+    uint64_t count = (inputSize - inputOffset) / sizeof(T);
+
+    DirectFile inFile(inputFile, false, directIO);
+    DirectFile outFile(outputFile, true, directIO);
+    DirectFileWriter outWriter(outFile, outputOffset);
+
+    size_t chunkElements = max<size_t>(RUN_BLOCK, min<size_t>(memoryLimit / 2, 8 << 20) / sizeof(T));
+    OutputCheck<T> check;
+    auto less = [](const T& a, const T& b) { return a < b; };
+    vector<T> buffer(min<uint64_t>(count, chunkElements));
+
+    for (uint64_t done = 0; done < count; ) {
+        size_t n = min<uint64_t>(buffer.size(), count - done);
+        uint64_t first = reverse ? count - done - n : done;
+        inFile.readAt(buffer.data(), n * sizeof(T), inputOffset + first * sizeof(T));
+        if (reverse) {
+            std::reverse(buffer.begin(), buffer.begin() + n);
+        }
+        if (verifyOutput) {
+            for (size_t i = 0; i < n; i++) {
+                check.add(buffer[i], 1, less);
+            }
+        }
+        outWriter.append(buffer.data(), n * sizeof(T));
+        done += n;
+    }
+    outWriter.finish();
+    outFile.close();
+    inFile.close();
+
+    if (verifyOutput) {
+        lastStats.verified = true;
+        lastStats.outputOrdered = check.ordered;
+        lastStats.outputHash = check.hash;
     }
-    rmdir(tempDir.c_str());
+
+    progress() << (reverse ? "Reversed " : "Copied ") << count << " elements" << endl;
 }
 
-// sort string file
-void ExternalSort::sortStringFile(const string& inputFile, const string& outputFile) {
-    cout << "Starting string external sort: " << inputFile << " -> " << outputFile << endl;
+// create initial sorted runs
+template<typename T>
+vector<RunInfo> ExternalSort::createInitialRuns(InputChunkReader& inFile, int64_t inputSize,
+                                              const vector<string>& tempDirs,
+                                              bool (*compare)(const T&, const T&)) {
+
+    // with several spill devices every device gets its own in-flight run
+    // write, so the memory budget is shared by those buffers and the one
+    // being filled
+    size_t devices = tempDirs.size();
+    size_t buffersInUse = devices > 1 ? devices + 1 : 1;
+
+    // a resumed job keeps its checkpointed runs and reads on after them
+    bool checkpointing = !checkpoint.path.empty();
+    vector<RunInfo> runs;
+    if (checkpointing && checkpoint.inputConsumed > 0) {
+        runs = checkpoint.runs;
+        inFile.seek(inputOffset + checkpoint.inputConsumed * sizeof(T));
+        if (inputSize >= 0) {
+            inputSize -= checkpoint.inputConsumed * sizeof(T);
+        }
+        progress() << "Resuming Phase 1 after " << runs.size() << " checkpointed runs ("
+                   << checkpoint.inputConsumed << " elements)" << endl;
+    }
+    size_t firstNew = runs.size();
 
-    // For strings, we use a simplified approach: read into memory and sort
-    // For large data, more complex processing would be needed
-    try {
-        // read data
-        auto data = DataGenerator::readStringData(inputFile);
+    // calculate number of elements per run
+    size_t elementSize = sizeof(T);
+    size_t bytesPerElement = elementSize * buffersInUse + sortScratchBytes(elementSize);
+    size_t elementsPerRun = max<size_t>(1, memoryLimit / bytesPerElement);
+
+    // a generous budget must not allocate more than a known input needs
+    if (inputSize >= 0) {
+        elementsPerRun = min<size_t>(elementsPerRun, max<int64_t>(1, inputSize / elementSize));
+    }
+
+    bool counted = mergeOutput == MergeOutputMode::COUNT;
 
-        // sort
-        sort(data.begin(), data.end(), compareString);
+    vector<T> buffer(elementsPerRun);
+    vector<future<RunInfo>> pendingWrites(devices);
+    vector<size_t> pendingRuns(devices);
+
+    // input elements and input hash behind every new run; a run enters the
+    // checkpoint once it and all earlier runs are on disk
+    vector<uint64_t> runInput;
+    vector<MultisetHash> runHash;
+    size_t recorded = firstNew;
+    auto recordFinished = [&]() {
+        if (!checkpointing) return;
+        size_t before = recorded;
+        while (recorded < runs.size() && !runs[recorded].path.empty()) {
+            saveRunIndex(runs[recorded]);
+            checkpoint.inputConsumed += runInput[recorded - firstNew];
+            checkpoint.inputHash.merge(runHash[recorded - firstNew]);
+            checkpoint.runs.push_back(runs[recorded]);
+            recorded++;
+        }
+        if (recorded != before) {
+            saveCheckpoint();
+        }
+    };
 
-        // write to output file
-        ofstream outFile(outputFile);
-        if (!outFile) {
-            throw runtime_error("Cannot open output file: " + outputFile);
+    auto finishWrite = [&](size_t device) {
+        if (pendingWrites[device].valid()) {
+            runs[pendingRuns[device]] = pendingWrites[device].get();
+            recordFinished();
         }
+    };
 
-        for (const auto& str : data) {
-            outFile << str << "\n";
+    while (true) {
+        // under rising memory pressure later runs get smaller
+        if (autoMemory) {
+            size_t held = elementsPerRun * elementSize * buffersInUse;
+            size_t budget = refreshMemoryBudget(held, true);
+            size_t shrunk = max<size_t>(1, budget / bytesPerElement);
+            if (shrunk < elementsPerRun) {
+                progress() << "Memory pressure: run size reduced from " << elementsPerRun
+                     << " to " << shrunk << " elements" << endl;
+                elementsPerRun = shrunk;
+                buffer.resize(elementsPerRun);
+                buffer.shrink_to_fit();
+            }
         }
-        outFile.close();
 
-        cout << "String external sort completed: " << outputFile << endl;
+        // read a batch of data (the buffer is reused for every run)
+        buffer.resize(elementsPerRun);
+        size_t bytesRead = inFile.read(reinterpret_cast<char*>(buffer.data()),
+                                       elementsPerRun * elementSize);
+        size_t elementsRead = bytesRead / elementSize;
 
-    } catch (const exception& e) {
-        cerr << "String external sort failed: " << e.what() << endl;
-        throw;
+        // a short read only happens at the end of the input: leftover bytes
+        // mean the input (or the upstream of a pipe) was truncated
+        if (bytesRead % elementSize != 0) {
+            throw runtime_error("Input ends with a partial element (" + to_string(bytesRead % elementSize) +
+                                " trailing bytes)");
+        }
+        if (elementsRead == 0) break;
+
+        // resize buffer
+        buffer.resize(elementsRead);
+
+        MultisetHash bufferHash;
+        if (verifyOutput) {
+            for (const T& value : buffer) {
+                bufferHash.add(elementHash(value));
+            }
+            lastStats.inputHash.merge(bufferHash);
+        }
+        runInput.push_back(elementsRead);
+        runHash.push_back(bufferHash);
+
+        // sort this batch across the worker threads
+        if (compare) {
+            parallelSort(buffer.data(), buffer.size(), compare);
+        } else {
+            parallelSort(buffer.data(), buffer.size(), less<T>());
+        }
+
+        // collapse duplicates so low-cardinality input spills less
+        vector<uint64_t> counts;
+        if (mergeOutput != MergeOutputMode::ALL) {
+            collapseSorted(buffer, counted ? &counts : nullptr, [compare](const T& a, const T& b) {
+                return compare ? compare(a, b) : a < b;
+            });
+        }
+
+        // write to temporary file
+        size_t runIndex = runs.size();
+        size_t device = pickTempDirectory(runIndex, bytesRead, devices);
+        string runFile = tempDirs[device] + "/run_" + to_string(runIndex) + ".dat";
+        runs.emplace_back();
+
+        auto writeRun = [runFile, counted](const vector<T>& data, const vector<uint64_t>& counts,
+                                           RunCodecType codec, bool direct) {
+            RunWriter<T> writer(runFile, codec, direct, counted);
+            if (counted) {
+                for (size_t i = 0; i < data.size(); i++) {
+                    writer.append(data[i], counts[i]);
+                }
+            } else {
+                writer.append(data.data(), data.size());
+            }
+            return writer.finish();
+        };
+
+        if (devices > 1) {
+            // hand the sorted buffer to the device's writer, keep reading
+            finishWrite(device);
+            auto data = make_shared<vector<T>>(move(buffer));
+            auto dataCounts = make_shared<vector<uint64_t>>(move(counts));
+            pendingRuns[device] = runIndex;
+            pendingWrites[device] = async(launch::async, [writeRun, data, dataCounts,
+                                                          codec = runCodec, direct = directIO]() {
+                return writeRun(*data, *dataCounts, codec, direct);
+            });
+            buffer = vector<T>(elementsPerRun);
+        } else {
+            runs[runIndex] = writeRun(buffer, counts, runCodec, directIO);
+            recordFinished();
+        }
+
+        progress() << "Created run " << runs.size() << " (" << elementsRead << " elements, "
+             << runFile << ")" << endl;
+    }
+
+    for (size_t device = 0; device < devices; device++) {
+        finishWrite(device);
+    }
+
+    for (const auto& run : runs) {
+        lastStats.spillBytes += runDiskBytes(run);
+        lastStats.rawSpillBytes += run.count * sizeof(T);
+    }
+    return runs;
+}
+
+// multi-way merge into a file
+template<typename T>
+void ExternalSort::mergeRuns(const vector<RunInfo>& runs,
+                           const string& outputFile,
+                           bool (*compare)(const T&, const T&)) {
+    // open output file
+    DirectFile outFile(outputFile, true, directIO);
+    DirectFileWriter outWriter(outFile, outputOffset);
+
+    uint64_t outputCount = mergeRunsInto<T>(runs, [&outWriter](const char* data, size_t n) {
+        outWriter.append(data, n);
+    }, compare);
+    outWriter.finish();
+    outFile.close();
+
+    progress() << "Merge completed, total " << outputCount << " elements output" << endl;
+}
+
+// multi-way merge; output batches go to write
+template<typename T>
+uint64_t ExternalSort::mergeRunsInto(const vector<RunInfo>& runs,
+                                     const function<void(const char*, size_t)>& write,
+                                     bool (*compare)(const T&, const T&)) {
+    int numRuns = runs.size();
+
+    // open all run files
+    vector<unique_ptr<DirectFile>> runFiles;
+    vector<unique_ptr<RunReader<T>>> readers;
+    size_t readerElements = numRuns > 0 ? memoryLimit / 2 / sizeof(T) / numRuns : 0;
+    readerElements = min<size_t>(readerElements, 1 << 20);
+
+    for (int i = 0; i < numRuns; i++) {
+        runFiles.push_back(make_unique<DirectFile>(runs[i].path, false, directIO));
+        readers.push_back(make_unique<RunReader<T>>(*runFiles[i], runs[i], 0, runs[i].count, readerElements));
+    }
+
+    auto less = [compare](const T& a, const T& b) {
+        return compare ? compare(a, b) : a < b;
+    };
+
+    MergeOutput<T> output(write, mergeOutput == MergeOutputMode::COUNT);
+    OutputCheck<T> check;
+    bool verify = verifyOutput;
+    bool distinct = mergeOutput == MergeOutputMode::DISTINCT;
+    uint64_t outputCount = heapMerge(readers, less, mergeOutput != MergeOutputMode::ALL,
+                                     [&](const T& value, uint64_t count) {
+        output.put(value, count);
+        if (verify) check.add(value, distinct ? 1 : count, less);
+    });
+    output.flush();
+
+    if (verify) {
+        lastStats.verified = true;
+        lastStats.outputOrdered = check.ordered;
+        lastStats.outputHash = check.hash;
+        lastStats.distinctOutput = distinct;
+    }
+    return outputCount;
+}
+
+// range-partitioned parallel merge: splitters sampled from the runs cut every
+// run into P disjoint key ranges, each merged by its own thread and written
+// with pwrite at a precomputed offset of the single output file
+template<typename T>
+void ExternalSort::parallelMergeRuns(const vector<RunInfo>& runs,
+                                   const string& outputFile,
+                                   bool (*compare)(const T&, const T&)) {
+#ifdef _WIN32
+    mergeRuns<T>(runs, outputFile, compare);
+#else
+    auto less = [compare](const T& a, const T& b) {
+        return compare ? compare(a, b) : a < b;
+    };
+
+    int numRuns = runs.size();
+    vector<unique_ptr<DirectFile>> runFiles;
+    uint64_t totalCount = 0;
+    for (int i = 0; i < numRuns; i++) {
+        runFiles.push_back(make_unique<DirectFile>(runs[i].path, false, directIO));
+        totalCount += runs[i].count;
+    }
+
+    // Distribution: the block index of every run is an evenly spaced sample
+    vector<T> samples;
+    for (const auto& run : runs) {
+        for (uint64_t key : run.blockFirstKeys) {
+            T first;
+            RunCodec::fromKey(key, first);
+            samples.push_back(first);
+        }
+    }
+    sort(samples.begin(), samples.end(), less);
+
+    const uint64_t MIN_PARTITION = 1 << 18;
+    size_t partitions = min<uint64_t>(getThreadCount(), max<uint64_t>(1, totalCount / MIN_PARTITION));
+    partitions = max<size_t>(1, min(partitions, samples.size()));
+
+    vector<T> splitters;
+    for (size_t p = 1; p < partitions; p++) {
+        splitters.push_back(samples[p * samples.size() / partitions]);
+    }
+    vector<T>().swap(samples);
+
+    // cut every run at the splitter boundaries
+    vector<vector<uint64_t>> cuts(numRuns, vector<uint64_t>(partitions + 1));
+    for (int r = 0; r < numRuns; r++) {
+        cuts[r][0] = 0;
+        for (size_t p = 1; p < partitions; p++) {
+            cuts[r][p] = lowerBoundInRun<T>(*runFiles[r], runs[r], splitters[p - 1], less);
+        }
+        cuts[r][partitions] = runs[r].count;
+    }
+
+    // output offsets of each key range
+    vector<uint64_t> offsets(partitions + 1, 0);
+    for (size_t p = 0; p < partitions; p++) {
+        uint64_t partitionCount = 0;
+        for (int r = 0; r < numRuns; r++) {
+            partitionCount += cuts[r][p + 1] - cuts[r][p];
+        }
+        offsets[p + 1] = offsets[p] + partitionCount;
+    }
+
+    DirectFile outFile(outputFile, true, directIO);
+    outFile.truncate(outputOffset + totalCount * sizeof(T));
+
+    progress() << "Merging " << partitions << " key ranges in parallel" << endl;
+
+    // half of the memory budget goes to the read buffers of all readers
+    size_t readerElements = memoryLimit / 2 / sizeof(T) / (partitions * numRuns);
+    readerElements = min<size_t>(readerElements, 1 << 20);
+
+    vector<thread> workers;
+    vector<string> errors(partitions);
+    vector<OutputCheck<T>> checks(partitions);
+    bool verify = verifyOutput;
+    for (size_t p = 0; p < partitions; p++) {
+        workers.emplace_back([&, p]() {
+            try {
+                vector<unique_ptr<RunReader<T>>> readers;
+                for (int r = 0; r < numRuns; r++) {
+                    readers.push_back(make_unique<RunReader<T>>(
+                        *runFiles[r], runs[r], cuts[r][p], cuts[r][p + 1], readerElements));
+                }
+
+                DirectFileWriter outWriter(outFile, outputOffset + offsets[p] * sizeof(T));
+                function<void(const char*, size_t)> write = [&outWriter](const char* data, size_t n) {
+                    outWriter.append(data, n);
+                };
+                MergeOutput<T> output(write, false);
+                OutputCheck<T>& check = checks[p];
+                heapMerge(readers, less, false, [&](const T& value, uint64_t count) {
+                    output.put(value, count);
+                    if (verify) check.add(value, count, less);
+                });
+                output.flush();
+                outWriter.finish();
+            } catch (const exception& e) {
+                errors[p] = e.what();
+            }
+        });
+    }
+    for (auto& worker : workers) worker.join();
+
+    for (const auto& error : errors) {
+        if (!error.empty()) {
+            throw runtime_error("Parallel merge failed: " + error);
+        }
+    }
+    outFile.close();
+
+    // key ranges are checked on their own, then across their boundaries
+    if (verify) {
+        lastStats.verified = true;
+        lastStats.outputOrdered = true;
+        lastStats.outputHash = MultisetHash();
+        const OutputCheck<T>* previous = nullptr;
+        for (const auto& check : checks) {
+            lastStats.outputOrdered = lastStats.outputOrdered && check.ordered;
+            lastStats.outputHash.merge(check.hash);
+            if (!check.any) continue;
+            if (previous && less(check.first, previous->last)) {
+                lastStats.outputOrdered = false;
+            }
+            previous = &check;
+        }
+    }
+
+    progress() << "Merge completed, total " << totalCount << " elements output" << endl;
+#endif
+}
+
+// intermediate merge passes: merge groups of fanIn runs into longer runs
+// until a single final merge can read all of them
+template<typename T>
+vector<RunInfo> ExternalSort::reduceRuns(vector<RunInfo> runs, const vector<string>& tempDirs,
+                                         size_t fanIn, bool (*compare)(const T&, const T&)) {
+    auto less = [compare](const T& a, const T& b) {
+        return compare ? compare(a, b) : a < b;
+    };
+
+    // a resumed job numbers its passes on from the checkpoint
+    bool checkpointing = !checkpoint.path.empty();
+    int pass = checkpointing ? checkpoint.mergePass : 0;
+    while (fanIn >= 2 && runs.size() > fanIn) {
+        pass++;
+        progress() << "Merge pass " << pass << ": " << runs.size() << " runs, fan-in " << fanIn << endl;
+
+        vector<RunInfo> merged;
+        size_t readerElements = min<size_t>(memoryLimit / 2 / sizeof(T) / fanIn, 1 << 20);
+
+        for (size_t first = 0; first < runs.size(); first += fanIn) {
+            size_t last = min(runs.size(), first + fanIn);
+            if (last - first == 1) {
+                merged.push_back(move(runs[first]));
+                continue;
+            }
+
+            vector<unique_ptr<DirectFile>> runFiles;
+            vector<unique_ptr<RunReader<T>>> readers;
+            for (size_t i = first; i < last; i++) {
+                runFiles.push_back(make_unique<DirectFile>(runs[i].path, false, directIO));
+                readers.push_back(make_unique<RunReader<T>>(*runFiles.back(), runs[i], 0,
+                                                            runs[i].count, readerElements));
+            }
+
+            size_t device = pickTempDirectory(merged.size(), 0, tempDirs.size());
+            string runFile = tempDirs[device] + "/pass" + to_string(pass) + "_run_" +
+                             to_string(merged.size()) + ".dat";
+            bool counted = mergeOutput == MergeOutputMode::COUNT;
+            RunWriter<T> writer(runFile, runCodec, directIO, counted);
+            heapMerge(readers, less, mergeOutput != MergeOutputMode::ALL,
+                      [&writer, counted](const T& value, uint64_t count) {
+                if (counted) {
+                    writer.append(value, count);
+                } else {
+                    writer.append(value);
+                }
+            });
+            merged.push_back(writer.finish());
+            lastStats.spillBytes += runDiskBytes(merged.back());
+
+            // checkpoint the merged run together with the runs still waiting
+            // in this pass before the group's inputs are deleted
+            if (checkpointing) {
+                saveRunIndex(merged.back());
+                checkpoint.runs = merged;
+                checkpoint.runs.insert(checkpoint.runs.end(), runs.begin() + last, runs.end());
+                checkpoint.mergePass = pass;
+                saveCheckpoint();
+            }
+
+            // the inputs of this group are no longer needed
+            readers.clear();
+            runFiles.clear();
+            for (size_t i = first; i < last; i++) {
+                removeRun(runs[i]);
+            }
+        }
+        runs = move(merged);
+    }
+
+    lastStats.mergePasses = pass + 1;
+    return runs;
+}
+
+namespace {
+
+// elapsed wall time since a phase started
+double secondsSince(chrono::steady_clock::time_point start) {
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+// I/O block size for string run files and the newline-delimited output
+const size_t STRING_IO_BLOCK = 1 << 20;
+
+// buffered bytes per string beyond its characters: offset and length in the
+// column plus the sort handle
+const size_t STRING_OVERHEAD = sizeof(uint64_t) + sizeof(uint32_t) + sizeof(StringColumn::Handle);
+
+// write a sorted string run in handle order (binary string format)
+void writeStringRun(const string& filename, const StringColumn& column,
+                    const vector<StringColumn::Handle>& order) {
+    FileUtils::writeBinaryStrings(filename, order.size(),
+                                  [&](size_t i) { return column[order[i].index]; });
+}
+
+// sequential cursor over a mapped string run; values point into the mapping
+class StringRunReader {
+public:
+    explicit StringRunReader(const string& filename) : strings(filename), position(0) {}
+
+    // next record, returns false at end of run
+    bool next(string_view& out) {
+        if (position == strings.size()) {
+            return false;
+        }
+        out = strings[position++];
+        return true;
+    }
+
+private:
+    BinaryStrings strings;
+    size_t position;
+};
+
+// createStringRuns source: newline-delimited text
+class LineSource {
+public:
+    explicit LineSource(istream& in) : in(in) {}
+
+    bool operator()(string_view& value) {
+        if (!getline(in, line)) {
+            return false;
+        }
+        value = line;
+        return true;
+    }
+
+private:
+    istream& in;
+    string line;
+};
+
+// createStringRuns source: binary string file, read in place
+class BinaryStringSource {
+public:
+    explicit BinaryStringSource(const BinaryStrings& strings) : strings(strings), position(0) {}
+
+    bool operator()(string_view& value) {
+        if (position == strings.size()) {
+            return false;
+        }
+        value = strings[position++];
+        return true;
+    }
+
+private:
+    const BinaryStrings& strings;
+    size_t position;
+};
+
+} // namespace
+
+// create sorted string runs bounded by a byte budget
+template<typename NextString>
+vector<string> ExternalSort::createStringRuns(NextString next, const vector<string>& tempDirs) {
+    // strings are buffered back to back in one arena; only 16-byte handles
+    // carrying a key prefix are moved by the sort
+    StringColumn buffer;
+    size_t bytesBuffered = 0;
+    size_t handleScratch = sortScratchBytes(sizeof(StringColumn::Handle));
+    vector<string> runFiles;
+    string_view value;
+
+    auto flushRun = [&]() {
+        auto handles = buffer.makeHandles();
+        parallelSort(handles.data(), handles.size(), buffer.handleLess());
+
+        size_t device = pickTempDirectory(runFiles.size(), bytesBuffered, tempDirs.size());
+        string runFile = tempDirs[device] + "/run_" + to_string(runFiles.size()) + ".dat";
+        writeStringRun(runFile, buffer, handles);
+        runFiles.push_back(runFile);
+
+        progress() << "Created run " << runFiles.size() << " (" << buffer.size() << " strings, "
+             << bytesBuffered << " bytes)" << endl;
+
+        buffer.clear();
+        bytesBuffered = 0;
+    };
+
+    while (next(value)) {
+        if (verifyOutput) {
+            lastStats.inputHash.add(stringHash(value));
+        }
+        bytesBuffered += value.size() + STRING_OVERHEAD + handleScratch;
+        buffer.push_back(value);
+
+        if (bytesBuffered >= memoryLimit) {
+            flushRun();
+        }
+    }
+
+    if (!buffer.empty()) {
+        flushRun();
+    }
+
+    return runFiles;
+}
+
+// multi-way merge of string runs, output is newline-delimited text
+void ExternalSort::mergeStringRuns(const vector<string>& runFiles,
+                                   const function<void(const char*, size_t)>& write) {
+    int numRuns = runFiles.size();
+
+    // runs are mapped, so the current values are views into the run files
+    vector<unique_ptr<StringRunReader>> readers;
+    vector<string_view> currentValues(numRuns);
+    for (int i = 0; i < numRuns; i++) {
+        readers.push_back(make_unique<StringRunReader>(runFiles[i]));
+    }
+
+    // heap entries carry a cached key prefix; full compare only on prefix ties
+    using Element = pair<uint64_t, int>;
+    auto heapCompare = [&currentValues](const Element& a, const Element& b) {
+        if (a.first != b.first) {
+            return b.first < a.first; // min-heap
+        }
+        int cmp = currentValues[a.second].compare(currentValues[b.second]);
+        return cmp != 0 ? cmp > 0 : a.second > b.second;
+    };
+
+    priority_queue<Element, vector<Element>, decltype(heapCompare)> minHeap(heapCompare);
+
+    for (int i = 0; i < numRuns; i++) {
+        if (readers[i]->next(currentValues[i])) {
+            minHeap.push({StringColumn::keyPrefix(currentValues[i]), i});
+        }
+    }
+
+    size_t outputCount = 0;
+    vector<char> outputBuffer;
+    outputBuffer.reserve(STRING_IO_BLOCK + 4096);
+    string_view previous;
+    lastStats.verified = verifyOutput;
+
+    while (!minHeap.empty()) {
+        int runIndex = minHeap.top().second;
+        minHeap.pop();
+
+        string_view value = currentValues[runIndex];
+        outputBuffer.insert(outputBuffer.end(), value.begin(), value.end());
+        outputBuffer.push_back('\n');
+        outputCount++;
+
+        if (verifyOutput) {
+            if (outputCount > 1 && value < previous) {
+                lastStats.outputOrdered = false;
+            }
+            previous = value;
+            lastStats.outputHash.add(stringHash(value));
+        }
+
+        if (outputBuffer.size() >= STRING_IO_BLOCK) {
+            write(outputBuffer.data(), outputBuffer.size());
+            outputBuffer.clear();
+        }
+
+        // read next value from the same run
+        if (readers[runIndex]->next(currentValues[runIndex])) {
+            minHeap.push({StringColumn::keyPrefix(currentValues[runIndex]), runIndex});
+        }
+    }
+
+    if (!outputBuffer.empty()) {
+        write(outputBuffer.data(), outputBuffer.size());
+    }
+
+    progress() << "Merge completed, total " << outputCount << " strings output" << endl;
+}
+
+namespace {
+
+// directory name of a resumable job, derived from its input and output paths
+string resumeKey(const string& inputFile, const string& outputFile) {
+    char key[17];
+    snprintf(key, sizeof(key), "%016llx",
+             static_cast<unsigned long long>(stringHash(inputFile + "\n" + outputFile)));
+    return key;
+}
+
+// modification time of a file (0 if it cannot be read)
+int64_t modifiedTime(const string& path) {
+    struct stat info;
+    return stat(path.c_str(), &info) == 0 ? static_cast<int64_t>(info.st_mtime) : 0;
+}
+
+} // namespace
+
+// write the checkpoint manifest; it goes to a temporary file renamed over the
+// old one, so a job dying mid-write leaves the previous manifest intact
+void ExternalSort::saveCheckpoint() {
+    string temp = checkpoint.path + ".tmp";
+    {
+        ofstream out(temp);
+        out << "external-sort-checkpoint 1\n";
+        out << "job " << checkpoint.jobKey << "\n";
+        out << "phase1 " << checkpoint.runsComplete << " " << checkpoint.inputConsumed << "\n";
+        out << "hash " << checkpoint.inputHash.sum << " " << checkpoint.inputHash.count << "\n";
+        out << "pass " << checkpoint.mergePass << "\n";
+        for (const auto& run : checkpoint.runs) {
+            out << "run " << static_cast<int>(run.codec) << " " << run.count << " " << run.bytes << " "
+                << run.checksum << " " << run.path << "\n";
+            if (!run.countPath.empty()) {
+                out << "count " << run.countChecksum << " " << run.countPath << "\n";
+            }
+        }
+        out << "end\n";
+        if (!out.flush()) {
+            throw runtime_error("Cannot write checkpoint: " + temp);
+        }
+    }
+#ifdef _WIN32
+    remove(checkpoint.path.c_str());
+#endif
+    if (rename(temp.c_str(), checkpoint.path.c_str()) != 0) {
+        throw runtime_error("Cannot write checkpoint: " + checkpoint.path);
+    }
+}
+
+// read the manifest of an earlier attempt and check every run it lists
+// against its size, checksum and block index (in parallel)
+bool ExternalSort::loadCheckpoint() {
+    ifstream in(checkpoint.path);
+    if (!in) return false;
+
+    auto reject = [](const string& reason) {
+        progress() << "Checkpoint not usable (" << reason << "), starting over" << endl;
+        return false;
+    };
+
+    SortCheckpoint loaded;
+    loaded.path = checkpoint.path;
+    loaded.jobKey = checkpoint.jobKey;
+    bool sameJob = false;
+    bool ended = false;
+
+    string line;
+    if (!getline(in, line) || line != "external-sort-checkpoint 1") {
+        return reject("unknown manifest format");
+    }
+    while (!ended && getline(in, line)) {
+        istringstream fields(line);
+        string word;
+        fields >> word;
+        if (word == "job") {
+            sameJob = line == "job " + checkpoint.jobKey;
+            if (!sameJob) return reject("input file or settings changed");
+        } else if (word == "phase1") {
+            fields >> loaded.runsComplete >> loaded.inputConsumed;
+        } else if (word == "hash") {
+            fields >> loaded.inputHash.sum >> loaded.inputHash.count;
+        } else if (word == "pass") {
+            fields >> loaded.mergePass;
+        } else if (word == "run") {
+            RunInfo run;
+            int codec = -1;
+            fields >> codec >> run.count >> run.bytes >> run.checksum;
+            fields.get();
+            getline(fields, run.path);
+            if (codec != static_cast<int>(RunCodecType::NONE) && codec != static_cast<int>(RunCodecType::DELTA_VARINT)) {
+                return reject("corrupt manifest line: " + line);
+            }
+            run.codec = static_cast<RunCodecType>(codec);
+            loaded.runs.push_back(move(run));
+        } else if (word == "count" && !loaded.runs.empty()) {
+            fields >> loaded.runs.back().countChecksum;
+            fields.get();
+            getline(fields, loaded.runs.back().countPath);
+        } else if (word == "end") {
+            ended = true;
+        } else {
+            return reject("corrupt manifest line: " + line);
+        }
+        if (fields.fail()) {
+            return reject("corrupt manifest line: " + line);
+        }
+    }
+    if (!sameJob || !ended) {
+        return reject("incomplete manifest");
+    }
+
+    vector<string> damaged(loaded.runs.size());
+    atomic<size_t> nextRun(0);
+    vector<thread> checkers;
+    for (unsigned t = 0; t < min<size_t>(getThreadCount(), loaded.runs.size()); t++) {
+        checkers.emplace_back([&]() {
+            for (size_t i = nextRun++; i < loaded.runs.size(); i = nextRun++) {
+                RunInfo& run = loaded.runs[i];
+                if (FileUtils::getFileSize(run.path) != static_cast<int64_t>(run.bytes) ||
+                    fileChecksum(run.path, 0, run.bytes) != run.checksum) {
+                    damaged[i] = "run " + run.path + " is damaged";
+                } else if (!run.countPath.empty() &&
+                           (FileUtils::getFileSize(run.countPath) != static_cast<int64_t>(run.count * sizeof(uint64_t)) ||
+                            fileChecksum(run.countPath, 0, run.count * sizeof(uint64_t)) != run.countChecksum)) {
+                    damaged[i] = "counts " + run.countPath + " are damaged";
+                } else if (!loadRunIndex(run)) {
+                    damaged[i] = "block index of " + run.path + " is damaged";
+                }
+            }
+        });
+    }
+    for (auto& checker : checkers) checker.join();
+    for (const auto& reason : damaged) {
+        if (!reason.empty()) return reject(reason);
+    }
+
+    checkpoint = move(loaded);
+    return true;
+}
+
+// external sort driver shared by the binary element types
+template<typename T>
+void ExternalSort::sortBinaryFile(const string& inputFile, const string& outputFile,
+                                  const string& typeName, const string& tempTag,
+                                  bool (*compare)(const T&, const T&)) {
+    progress() << "Starting " << typeName << " external sort: " << inputFile << " -> " << outputFile << endl;
+
+    lastStats = ExternalSortStats();
+    if (autoMemory) {
+        refreshMemoryBudget(0, false);
+        progress() << "Auto memory budget: " << memoryLimit / (1024 * 1024) << " MB" << endl;
+    }
+
+    // an input with a data file header is sorted past the header, and the
+    // output gets the same header marked sorted (count, min/max and checksum
+    // do not change under a permutation); collapsed output is written raw
+    DataFileHeader inputHeader;
+    bool headered = FileUtils::readDataHeader(inputFile, inputHeader, DataFileHeader::typeOf<T>());
+    inputOffset = headered ? sizeof(DataFileHeader) : 0;
+    outputOffset = headered && mergeOutput == MergeOutputMode::ALL ? sizeof(DataFileHeader) : 0;
+    int64_t inputBytes = FileUtils::getFileSize(inputFile);
+    if (inputBytes >= 0 && (inputBytes - inputOffset) % sizeof(T) != 0) {
+        inputOffset = outputOffset = 0;
+        throw runtime_error("Input size is not a multiple of the element size: " + inputFile);
+    }
+    auto finishOutput = [&]() {
+        if (outputOffset > 0) {
+            DataFileHeader outputHeader = inputHeader;
+            outputHeader.flags |= DATA_FLAG_SORTED;
+            FileUtils::writeDataHeader(outputFile, outputHeader);
+        }
+        inputOffset = outputOffset = 0;
+    };
+
+    // a resumable job looks for the checkpoint of an earlier attempt first
+    auto phaseStart = chrono::steady_clock::now();
+    vector<string> tempDirs;
+    checkpoint = SortCheckpoint();
+    bool resumed = false;
+    if (resumable) {
+        tempDirs = createJobDirectories(tempTag, resumeKey(inputFile, outputFile));
+        checkpoint.path = tempDirs[0] + "/manifest.txt";
+        checkpoint.jobKey = tempTag + " size " + to_string(FileUtils::getFileSize(inputFile)) +
+                            " mtime " + to_string(modifiedTime(inputFile)) +
+                            " codec " + to_string(static_cast<int>(runCodec)) +
+                            " output " + to_string(static_cast<int>(mergeOutput)) +
+                            " verify " + to_string(verifyOutput) + " block " + to_string(RUN_BLOCK);
+        resumed = loadCheckpoint();
+        if (resumed) {
+            lastStats.resumedRuns = checkpoint.runs.size();
+            progress() << "Resuming from checkpoint: " << checkpoint.runs.size() << " runs"
+                       << (checkpoint.runsComplete ? ", Phase 1 complete" : "")
+                       << ", " << checkpoint.mergePass << " merge passes" << endl;
+        } else {
+            // leftovers of an attempt that cannot be reused
+            for (const auto& dir : tempDirs) {
+                FileUtils::cleanDirectory(dir);
+            }
+        }
+    }
+
+    // sorted or reverse-sorted input needs a single pass and no temp space
+    // a header flagged sorted stands in for the scan, unless the output is
+    // verified (that needs the input hash the scan computes) or collapsed
+    // (that merges the input as a natural run)
+    vector<RunInfo> naturalRuns;
+    if (headered && inputHeader.sorted() && !verifyOutput && !resumed &&
+        mergeOutput == MergeOutputMode::ALL) {
+        progress() << "Input header is flagged sorted" << endl;
+        lastStats.presort = PresortKind::SORTED;
+    } else if (detectPresorted && !resumed) {
+        lastStats.presort = scanPresorted<T>(inputFile, naturalRuns, compare);
+    }
+    if (mergeOutput != MergeOutputMode::ALL) {
+        // duplicates still have to be collapsed: sorted input is merged as a
+        // single natural run, reversed input takes the regular path
+        if (lastStats.presort == PresortKind::SORTED) {
+            lastStats.presort = PresortKind::NATURAL_RUNS;
+        } else if (lastStats.presort == PresortKind::REVERSED) {
+            lastStats.presort = PresortKind::UNSORTED;
+        }
+    }
+    if (lastStats.presort == PresortKind::SORTED || lastStats.presort == PresortKind::REVERSED) {
+        bool reverse = lastStats.presort == PresortKind::REVERSED;
+        progress() << "Input is already " << (reverse ? "in reverse order, reversing" : "sorted, copying") << endl;
+        lastStats.runPhaseSeconds = secondsSince(phaseStart);
+        phaseStart = chrono::steady_clock::now();
+        copyInput<T>(inputFile, outputFile, reverse);
+        finishOutput();
+        lastStats.mergePhaseSeconds = secondsSince(phaseStart);
+        removeJobDirectories(tempDirs);
+        progress() << "External sort completed (" << typeName << "): " << outputFile << endl;
+        return;
+    }
+
+    // natural runs are merged straight from the input: no Phase 1 to resume
+    if (lastStats.presort == PresortKind::NATURAL_RUNS) {
+        checkpoint.path.clear();
+    }
+
+    // create temporary directories (one per spill device)
+    if (tempDirs.empty()) {
+        tempDirs = createJobDirectories(tempTag);
+    }
+
+    vector<RunInfo> runs;
+
+    try {
+        // Phase 1: create initial runs, unless the input already consists of
+        // a few sorted runs that can be merged in place
+        if (lastStats.presort == PresortKind::NATURAL_RUNS) {
+            progress() << "Phase 1: Skipped, input consists of " << naturalRuns.size() << " sorted runs" << endl;
+            runs = move(naturalRuns);
+        } else if (resumed && checkpoint.runsComplete) {
+            progress() << "Phase 1: Skipped, resuming with " << checkpoint.runs.size() << " checkpointed runs" << endl;
+            runs = checkpoint.runs;
+            lastStats.inputHash = checkpoint.inputHash;
+        } else {
+            // the pre-scan stopped early: hash the input while creating runs
+            // (a resumed job starts from the hash of the checkpointed runs)
+            lastStats.inputHash = checkpoint.inputHash;
+            progress() << "Phase 1: Creating initial runs (" << getThreadCount() << " threads)..." << endl;
+            InputChunkReader inFile(inputFile, inputMode);
+            inFile.seek(inputOffset);
+            runs = createInitialRuns<T>(inFile, FileUtils::getFileSize(inputFile) - inputOffset, tempDirs, compare);
+            if (!checkpoint.path.empty()) {
+                checkpoint.runsComplete = true;
+                saveCheckpoint();
+            }
+        }
+        lastStats.runPhaseSeconds = secondsSince(phaseStart);
+        lastStats.runCount = runs.size();
+        lastStats.memoryBudget = memoryLimit;
+
+        // Phase 2: multi-way merge (more runs than the fan-in allows need
+        // intermediate passes first)
+        progress() << "Phase 2: Multi-way merge (" << runs.size() << " runs)..." << endl;
+        phaseStart = chrono::steady_clock::now();
+        refreshMemoryBudget(0, true);
+        lastStats.mergeFanIn = getMergeFanIn();
+        runs = reduceRuns<T>(move(runs), tempDirs, lastStats.mergeFanIn, compare);
+        // collapsed output has no precomputable offsets: merge sequentially
+        if (getThreadCount() > 1 && runs.size() > 1 && mergeOutput == MergeOutputMode::ALL) {
+            parallelMergeRuns<T>(runs, outputFile, compare);
+        } else {
+            mergeRuns<T>(runs, outputFile, compare);
+        }
+        finishOutput();
+        lastStats.mergePhaseSeconds = secondsSince(phaseStart);
+
+        progress() << "External sort completed (" << typeName << "): " << outputFile << endl;
+
+    } catch (const exception& e) {
+        // a resumable job keeps its runs and manifest for the next attempt;
+        // otherwise cleanup temporary files (including a partially written run)
+        inputOffset = outputOffset = 0;
+        if (!checkpoint.path.empty()) {
+            progress() << "Sort failed, checkpoint kept in " << tempDirs[0] << endl;
+        } else {
+            removeJobDirectories(tempDirs);
+        }
+        throw;
+    }
+
+    // cleanup temporary files
+    for (const auto& run : runs) {
+        removeRun(run);
+    }
+    removeJobDirectories(tempDirs);
+    checkpoint = SortCheckpoint();
+}
+
+// sort integer file
+void ExternalSort::sortIntegerFile(const string& inputFile, const string& outputFile) {
+    sortBinaryFile<int64_t>(inputFile, outputFile, "integer", "int", compareInt);
+}
+
+// sort double file
+void ExternalSort::sortDoubleFile(const string& inputFile, const string& outputFile) {
+    sortBinaryFile<double>(inputFile, outputFile, "double", "double", compareDouble);
+}
+
+// streaming driver for the binary element types: the input length is
+// unknown, so there is no pre-scan and the merge writes sequentially to out;
+// progress goes to stderr so it never mixes with the sorted data
+template<typename T>
+void ExternalSort::sortBinaryStream(istream& in, ostream& out,
+                                    const string& typeName, const string& tempTag,
+                                    bool (*compare)(const T&, const T&)) {
+    ostream* previousProgress = progressOut;
+    progressOut = &cerr;
+
+    progress() << "Starting " << typeName << " stream external sort" << endl;
+
+    lastStats = ExternalSortStats();
+    if (autoMemory) {
+        refreshMemoryBudget(0, false);
+        progress() << "Auto memory budget: " << memoryLimit / (1024 * 1024) << " MB" << endl;
+    }
+
+    vector<string> tempDirs = createJobDirectories(tempTag);
+    vector<RunInfo> runs;
+
+    try {
+        // Phase 1: spill a run whenever the buffer fills
+        progress() << "Phase 1: Creating initial runs (" << getThreadCount() << " threads)..." << endl;
+        auto phaseStart = chrono::steady_clock::now();
+        InputChunkReader inFile(in);
+        runs = createInitialRuns<T>(inFile, -1, tempDirs, compare);
+        lastStats.runPhaseSeconds = secondsSince(phaseStart);
+        lastStats.runCount = runs.size();
+        lastStats.memoryBudget = memoryLimit;
+
+        // Phase 2: multi-way merge straight into the output stream
+        progress() << "Phase 2: Multi-way merge (" << runs.size() << " runs)..." << endl;
+        phaseStart = chrono::steady_clock::now();
+        refreshMemoryBudget(0, true);
+        lastStats.mergeFanIn = getMergeFanIn();
+        runs = reduceRuns<T>(move(runs), tempDirs, lastStats.mergeFanIn, compare);
+        uint64_t outputCount = mergeRunsInto<T>(runs, [&out](const char* data, size_t n) {
+            out.write(data, n);
+        }, compare);
+        out.flush();
+        if (!out) {
+            throw runtime_error("Failed to write sorted output stream");
+        }
+        lastStats.mergePhaseSeconds = secondsSince(phaseStart);
+
+        progress() << "Merge completed, total " << outputCount << " elements output" << endl;
+
+    } catch (const exception& e) {
+        removeJobDirectories(tempDirs);
+        progressOut = previousProgress;
+        throw;
+    }
+
+    for (const auto& run : runs) {
+        removeRun(run);
+    }
+    removeJobDirectories(tempDirs);
+    progressOut = previousProgress;
+}
+
+// sort integers from a stream
+void ExternalSort::sortIntegerStream(istream& in, ostream& out) {
+    sortBinaryStream<int64_t>(in, out, "integer", "int", compareInt);
+}
+
+// sort doubles from a stream
+void ExternalSort::sortDoubleStream(istream& in, ostream& out) {
+    sortBinaryStream<double>(in, out, "double", "double", compareDouble);
+}
+
+// sort string file
+void ExternalSort::sortStringFile(const string& inputFile, const string& outputFile) {
+    progress() << "Starting string external sort: " << inputFile << " -> " << outputFile << endl;
+
+    lastStats = ExternalSortStats();
+
+    // create temporary directories (one per spill device)
+    vector<string> tempDirs = createJobDirectories("string");
+
+    vector<string> runFiles;
+
+    try {
+        // Phase 1: create initial runs
+        progress() << "Phase 1: Creating initial runs (" << getThreadCount() << " threads)..." << endl;
+        auto phaseStart = chrono::steady_clock::now();
+        if (FileUtils::isBinaryStringFile(inputFile)) {
+            BinaryStrings input(inputFile);
+            runFiles = createStringRuns(BinaryStringSource(input), tempDirs);
+        } else {
+            ifstream inFile(inputFile);
+            if (!inFile) {
+                throw runtime_error("Cannot open input file: " + inputFile);
+            }
+            runFiles = createStringRuns(LineSource(inFile), tempDirs);
+        }
+        lastStats.runPhaseSeconds = secondsSince(phaseStart);
+        lastStats.runCount = runFiles.size();
+
+        // Phase 2: multi-way merge
+        progress() << "Phase 2: Multi-way merge (" << runFiles.size() << " runs)..." << endl;
+        phaseStart = chrono::steady_clock::now();
+        // full blocks go to the file with pwrite, bypassing stream formatting
+        OutputFile outFile(outputFile);
+        BlockWriter outWriter(outFile, 0);
+        mergeStringRuns(runFiles, [&outWriter](const char* data, size_t n) { outWriter.write(data, n); });
+        outWriter.finish();
+        outFile.close();
+        lastStats.mergePhaseSeconds = secondsSince(phaseStart);
+
+        progress() << "String external sort completed: " << outputFile << endl;
+
+    } catch (const exception& e) {
+        cerr << "String external sort failed: " << e.what() << endl;
+        // cleanup temporary files (including a partially written run)
+        removeJobDirectories(tempDirs);
+        throw;
+    }
+
+    // cleanup temporary files
+    for (const auto& file : runFiles) {
+        remove(file.c_str());
+    }
+    removeJobDirectories(tempDirs);
+}
+
+// sort newline-separated strings from a stream
+void ExternalSort::sortStringStream(istream& in, ostream& out) {
+    ostream* previousProgress = progressOut;
+    progressOut = &cerr;
+
+    progress() << "Starting string stream external sort" << endl;
+
+    lastStats = ExternalSortStats();
+    vector<string> tempDirs = createJobDirectories("string");
+    vector<string> runFiles;
+
+    try {
+        progress() << "Phase 1: Creating initial runs (" << getThreadCount() << " threads)..." << endl;
+        auto phaseStart = chrono::steady_clock::now();
+        runFiles = createStringRuns(LineSource(in), tempDirs);
+        lastStats.runPhaseSeconds = secondsSince(phaseStart);
+        lastStats.runCount = runFiles.size();
+
+        progress() << "Phase 2: Multi-way merge (" << runFiles.size() << " runs)..." << endl;
+        phaseStart = chrono::steady_clock::now();
+        mergeStringRuns(runFiles, [&out](const char* data, size_t n) { out.write(data, n); });
+        out.flush();
+        if (!out) {
+            throw runtime_error("Failed to write sorted strings");
+        }
+        lastStats.mergePhaseSeconds = secondsSince(phaseStart);
+
+    } catch (const exception& e) {
+        removeJobDirectories(tempDirs);
+        progressOut = previousProgress;
+        throw;
+    }
+
+    for (const auto& file : runFiles) {
+        remove(file.c_str());
+    }
+    removeJobDirectories(tempDirs);
+    progressOut = previousProgress;
+}
+
+namespace {
+
+// keys of fixed-width records. less() is the sort order, prefix() an
+// order-preserving 64-bit image used for key+index tags; when exact() the
+// prefix alone decides the order. WIDTH is the key width known at compile
+// time (0 when only known at run time)
+
+// signed little-endian integer key
+template<typename I>
+struct IntegerKey {
+    static const size_t WIDTH = sizeof(I);
+    size_t offset;
+
+    I get(const char* record) const {
+        I value;
+        memcpy(&value, record + offset, sizeof(I));
+        return value;
+    }
+    bool less(const char* a, const char* b) const { return get(a) < get(b); }
+    uint64_t prefix(const char* record) const {
+        return static_cast<uint64_t>(static_cast<int64_t>(get(record))) ^ (1ULL << 63);
+    }
+    bool exact() const { return true; }
+};
+
+// float or double key
+template<typename F>
+struct FloatKey {
+    static const size_t WIDTH = sizeof(F);
+    size_t offset;
+
+    F get(const char* record) const {
+        F value;
+        memcpy(&value, record + offset, sizeof(F));
+        return value;
+    }
+    bool less(const char* a, const char* b) const { return get(a) < get(b); }
+    uint64_t prefix(const char* record) const { return RunCodec::toKey(static_cast<double>(get(record))); }
+    bool exact() const { return true; }
+};
+
+// byte-string key compared with memcmp; W = 0 takes the width at run time
+template<size_t W>
+struct BytesKey {
+    static const size_t WIDTH = W;
+    size_t offset;
+    size_t runtimeWidth;
+
+    size_t width() const { return W > 0 ? W : runtimeWidth; }
+    bool less(const char* a, const char* b) const {
+        return memcmp(a + offset, b + offset, width()) < 0;
+    }
+    uint64_t prefix(const char* record) const {
+        const unsigned char* p = reinterpret_cast<const unsigned char*>(record + offset);
+        size_t n = min<size_t>(width(), 8);
+        uint64_t value = 0;
+        for (size_t i = 0; i < 8; i++) {
+            value = (value << 8) | (i < n ? p[i] : 0);
+        }
+        return value;
+    }
+    bool exact() const { return width() <= 8; }
+};
+
+// a record sorted in place (small record sizes, padded to a multiple of 8)
+template<size_t N>
+struct FixedRecord {
+    char bytes[N];
+};
+
+// key prefix and position of a record in the run buffer (large records)
+struct RecordTag {
+    uint64_t prefix;
+    uint32_t index;
+};
+
+// records above this size are sorted through key+index tags
+const size_t TAG_RECORD_SIZE = 64;
+
+// buffered sequential reader over a run of fixed-width records
+class RecordRunReader {
+public:
+    RecordRunReader(const string& path, size_t recordSize, size_t bufferRecords, bool direct)
+        : file(path, false, direct), recordSize(recordSize), offset(0), pos(0), filled(0) {
+        int64_t size = FileUtils::getFileSize(path);
+        fileSize = size > 0 ? size : 0;
+        buffer.resize(max<size_t>(1, bufferRecords) * recordSize);
+    }
+
+    // load the first record; false for an empty run
+    bool start() { return refill(); }
+
+    const char* current() const { return buffer.data() + pos; }
+
+    bool advance() {
+        pos += recordSize;
+        return pos < filled || refill();
+    }
+
+private:
+    DirectFile file;
+    size_t recordSize;
+    uint64_t fileSize;
+    uint64_t offset;
+    vector<char> buffer;
+    size_t pos;
+    size_t filled;
+
+    bool refill() {
+        if (offset >= fileSize) return false;
+        filled = min<uint64_t>(buffer.size(), fileSize - offset);
+        file.readAt(buffer.data(), filled, offset);
+        offset += filled;
+        pos = 0;
+        return true;
+    }
+};
+
+} // namespace
+
+// create sorted runs of fixed-width records
+template<typename Key>
+vector<string> ExternalSort::createRecordRuns(const string& inputFile, const vector<string>& tempDirs,
+                                              size_t recordSize, const Key& key) {
+    InputChunkReader inFile(inputFile, inputMode);
+
+    // small records are sorted directly in slots rounded up to a multiple of 8 bytes;
+    // tagged runs also hold one tag per record
+    bool tagged = recordSize > TAG_RECORD_SIZE;
+    size_t slotSize = (recordSize + 7) / 8 * 8;
+    size_t bytesPerRecord = tagged ? recordSize + sizeof(RecordTag) + sortScratchBytes(sizeof(RecordTag))
+                                   : slotSize + sortScratchBytes(slotSize);
+    size_t recordsPerRun = max<size_t>(1, memoryLimit / bytesPerRecord);
+    recordsPerRun = min<size_t>(recordsPerRun, UINT32_MAX);
+
+    int64_t inputSize = FileUtils::getFileSize(inputFile);
+    if (inputSize >= 0) {
+        recordsPerRun = min<size_t>(recordsPerRun, max<int64_t>(1, inputSize / recordSize));
+    }
+
+    vector<char> buffer(recordsPerRun * (tagged ? recordSize : slotSize));
+    vector<RecordTag> tags;
+    vector<string> runFiles;
+
+    // direct sort of small records, viewed in place as FixedRecord<N>; slots narrower
+    // than the key never occur and are not instantiated
+    auto sortDirect = [&](auto size, size_t count) {
+        using Record = FixedRecord<decltype(size)::value>;
+        if constexpr (sizeof(Record) >= Key::WIDTH) {
+            parallelSort(reinterpret_cast<Record*>(buffer.data()), count,
+                         [&key](const Record& a, const Record& b) { return key.less(a.bytes, b.bytes); });
+        }
+    };
+
+    while (true) {
+        size_t bytesRead = inFile.read(buffer.data(), recordsPerRun * recordSize);
+        if (bytesRead == 0) break;
+        if (bytesRead % recordSize != 0) {
+            throw runtime_error("Input size is not a multiple of the record size: " + inputFile);
+        }
+        size_t count = bytesRead / recordSize;
+
+        size_t device = pickTempDirectory(runFiles.size(), bytesRead, tempDirs.size());
+        string runFile = tempDirs[device] + "/run_" + to_string(runFiles.size()) + ".dat";
+        DirectFile outFile(runFile, true, directIO);
+        DirectFileWriter outWriter(outFile, 0);
+
+        if (!tagged) {
+            // spread the records out to their slots (back to front, slots never overlap
+            // records not yet moved) and pack them again after sorting
+            char* records = buffer.data();
+            if (slotSize != recordSize) {
+                for (size_t i = count; i-- > 0;) {
+                    memmove(records + i * slotSize, records + i * recordSize, recordSize);
+                }
+            }
+            switch (slotSize) {
+                case 8: sortDirect(integral_constant<size_t, 8>(), count); break;
+                case 16: sortDirect(integral_constant<size_t, 16>(), count); break;
+                case 24: sortDirect(integral_constant<size_t, 24>(), count); break;
+                case 32: sortDirect(integral_constant<size_t, 32>(), count); break;
+                case 40: sortDirect(integral_constant<size_t, 40>(), count); break;
+                case 48: sortDirect(integral_constant<size_t, 48>(), count); break;
+                case 56: sortDirect(integral_constant<size_t, 56>(), count); break;
+                default: sortDirect(integral_constant<size_t, TAG_RECORD_SIZE>(), count); break;
+            }
+            if (slotSize != recordSize) {
+                for (size_t i = 1; i < count; i++) {
+                    memmove(records + i * recordSize, records + i * slotSize, recordSize);
+                }
+            }
+            outWriter.append(records, bytesRead);
+        } else {
+            // sort (prefix, index) tags, then write the records in tag order
+            const char* records = buffer.data();
+            tags.resize(count);
+            for (size_t i = 0; i < count; i++) {
+                tags[i] = {key.prefix(records + i * recordSize), static_cast<uint32_t>(i)};
+            }
+            parallelSort(tags.data(), count, [&key, records, recordSize](const RecordTag& a, const RecordTag& b) {
+                if (a.prefix != b.prefix) return a.prefix < b.prefix;
+                if (!key.exact()) {
+                    const char* ra = records + a.index * recordSize;
+                    const char* rb = records + b.index * recordSize;
+                    if (key.less(ra, rb)) return true;
+                    if (key.less(rb, ra)) return false;
+                }
+                return a.index < b.index;
+            });
+
+            vector<char> batch;
+            batch.reserve(RUN_WRITE_BUFFER + recordSize);
+            for (const auto& tag : tags) {
+                const char* record = records + tag.index * recordSize;
+                batch.insert(batch.end(), record, record + recordSize);
+                if (batch.size() >= RUN_WRITE_BUFFER) {
+                    outWriter.append(batch.data(), batch.size());
+                    batch.clear();
+                }
+            }
+            outWriter.append(batch.data(), batch.size());
+        }
+        outWriter.finish();
+        outFile.close();
+
+        runFiles.push_back(runFile);
+        lastStats.spillBytes += bytesRead;
+        lastStats.rawSpillBytes += bytesRead;
+
+        progress() << "Created run " << runFiles.size() << " (" << count << " records, "
+             << runFile << ")" << endl;
+    }
+    return runFiles;
+}
+
+// multi-way merge of fixed-width record runs
+template<typename Key>
+uint64_t ExternalSort::mergeRecordRuns(const vector<string>& runFiles, const string& outputFile,
+                                       size_t recordSize, const Key& key) {
+    size_t numRuns = runFiles.size();
+    size_t bufferRecords = numRuns > 0 ? memoryLimit / 2 / recordSize / numRuns : 0;
+    bufferRecords = min<size_t>(bufferRecords, (1 << 20) / recordSize + 1);
+
+    vector<unique_ptr<RecordRunReader>> readers;
+    for (const auto& file : runFiles) {
+        readers.push_back(make_unique<RecordRunReader>(file, recordSize, bufferRecords, directIO));
+    }
+
+    // min-heap of run indices ordered by each run's current record
+    auto heapCompare = [&readers, &key](size_t a, size_t b) {
+        return key.less(readers[b]->current(), readers[a]->current());
+    };
+    priority_queue<size_t, vector<size_t>, decltype(heapCompare)> minHeap(heapCompare);
+    for (size_t i = 0; i < numRuns; i++) {
+        if (readers[i]->start()) {
+            minHeap.push(i);
+        }
+    }
+
+    DirectFile outFile(outputFile, true, directIO);
+    DirectFileWriter outWriter(outFile, 0);
+
+    uint64_t outputCount = 0;
+    vector<char> batch;
+    batch.reserve(RUN_WRITE_BUFFER + recordSize);
+
+    while (!minHeap.empty()) {
+        size_t runIndex = minHeap.top();
+        minHeap.pop();
+
+        const char* record = readers[runIndex]->current();
+        batch.insert(batch.end(), record, record + recordSize);
+        outputCount++;
+        if (batch.size() >= RUN_WRITE_BUFFER) {
+            outWriter.append(batch.data(), batch.size());
+            batch.clear();
+        }
+
+        if (readers[runIndex]->advance()) {
+            minHeap.push(runIndex);
+        }
+    }
+
+    outWriter.append(batch.data(), batch.size());
+    outWriter.finish();
+    outFile.close();
+    return outputCount;
+}
+
+// external sort driver for fixed-width records
+template<typename Key>
+void ExternalSort::sortRecordsByKey(const string& inputFile, const string& outputFile,
+                                    size_t recordSize, const Key& key) {
+    progress() << "Starting record external sort (" << recordSize << "-byte records): "
+         << inputFile << " -> " << outputFile << endl;
+
+    lastStats = ExternalSortStats();
+    if (autoMemory) {
+        refreshMemoryBudget(0, false);
+        progress() << "Auto memory budget: " << memoryLimit / (1024 * 1024) << " MB" << endl;
+    }
+
+    vector<string> tempDirs = createJobDirectories("record");
+    vector<string> runFiles;
+
+    try {
+        // Phase 1: create initial runs
+        progress() << "Phase 1: Creating initial runs (" << getThreadCount() << " threads)..." << endl;
+        auto phaseStart = chrono::steady_clock::now();
+        runFiles = createRecordRuns(inputFile, tempDirs, recordSize, key);
+        lastStats.runPhaseSeconds = secondsSince(phaseStart);
+        lastStats.runCount = runFiles.size();
+        lastStats.memoryBudget = memoryLimit;
+
+        // Phase 2: multi-way merge, with intermediate passes above the fan-in
+        progress() << "Phase 2: Multi-way merge (" << runFiles.size() << " runs)..." << endl;
+        phaseStart = chrono::steady_clock::now();
+        refreshMemoryBudget(0, true);
+        size_t fanIn = getMergeFanIn();
+        lastStats.mergeFanIn = fanIn;
+
+        int pass = 0;
+        while (fanIn >= 2 && runFiles.size() > fanIn) {
+            pass++;
+            progress() << "Merge pass " << pass << ": " << runFiles.size() << " runs, fan-in " << fanIn << endl;
+
+            vector<string> merged;
+            for (size_t first = 0; first < runFiles.size(); first += fanIn) {
+                size_t last = min(runFiles.size(), first + fanIn);
+                vector<string> group(runFiles.begin() + first, runFiles.begin() + last);
+                if (group.size() == 1) {
+                    merged.push_back(group[0]);
+                    continue;
+                }
+
+                size_t device = pickTempDirectory(merged.size(), 0, tempDirs.size());
+                string runFile = tempDirs[device] + "/pass" + to_string(pass) + "_run_" +
+                                 to_string(merged.size()) + ".dat";
+                uint64_t count = mergeRecordRuns(group, runFile, recordSize, key);
+                lastStats.spillBytes += count * recordSize;
+                merged.push_back(runFile);
+
+                for (const auto& file : group) {
+                    remove(file.c_str());
+                }
+            }
+            runFiles = move(merged);
+        }
+        lastStats.mergePasses = pass + 1;
+
+        uint64_t outputCount = mergeRecordRuns(runFiles, outputFile, recordSize, key);
+        lastStats.mergePhaseSeconds = secondsSince(phaseStart);
+
+        progress() << "Merge completed, total " << outputCount << " records output" << endl;
+        progress() << "Record external sort completed: " << outputFile << endl;
+
+    } catch (const exception& e) {
+        // cleanup temporary files (including a partially written run)
+        removeJobDirectories(tempDirs);
+        throw;
+    }
+
+    // cleanup temporary files
+    for (const auto& file : runFiles) {
+        remove(file.c_str());
+    }
+    removeJobDirectories(tempDirs);
+}
+
+// sort fixed-width record file: pick the key extraction for the format
+void ExternalSort::sortRecordFile(const string& inputFile, const string& outputFile,
+                                  const RecordFormat& format) {
+    size_t recordSize = format.recordSize;
+    size_t offset = format.keyOffset;
+    size_t width = format.keyWidth;
+
+    if (recordSize == 0 || width == 0 || offset + width > recordSize) {
+        throw runtime_error("Invalid record format: key must lie inside a non-empty record");
+    }
+
+    switch (format.keyType) {
+        case RecordKeyType::INTEGER:
+            switch (width) {
+                case 1: sortRecordsByKey(inputFile, outputFile, recordSize, IntegerKey<int8_t>{offset}); return;
+                case 2: sortRecordsByKey(inputFile, outputFile, recordSize, IntegerKey<int16_t>{offset}); return;
+                case 4: sortRecordsByKey(inputFile, outputFile, recordSize, IntegerKey<int32_t>{offset}); return;
+                case 8: sortRecordsByKey(inputFile, outputFile, recordSize, IntegerKey<int64_t>{offset}); return;
+            }
+            throw runtime_error("Integer record keys must be 1, 2, 4 or 8 bytes wide");
+
+        case RecordKeyType::DOUBLE:
+            switch (width) {
+                case 4: sortRecordsByKey(inputFile, outputFile, recordSize, FloatKey<float>{offset}); return;
+                case 8: sortRecordsByKey(inputFile, outputFile, recordSize, FloatKey<double>{offset}); return;
+            }
+            throw runtime_error("Floating point record keys must be 4 or 8 bytes wide");
+
+        case RecordKeyType::BYTES:
+            switch (width) {
+                case 8: sortRecordsByKey(inputFile, outputFile, recordSize, BytesKey<8>{offset, width}); return;
+                case 16: sortRecordsByKey(inputFile, outputFile, recordSize, BytesKey<16>{offset, width}); return;
+                default: sortRecordsByKey(inputFile, outputFile, recordSize, BytesKey<0>{offset, width}); return;
+            }
     }
 }
@@ -4,12 +4,25 @@
 #include <sys/stat.h>
 #include <dirent.h>
 #include <cstring>
+#include <cerrno>
+#include <stdexcept>
+#include <algorithm>
+#include <thread>
+#include <functional>
+#include <mutex>
 
 #ifdef _WIN32
 #include <windows.h>
 #include <direct.h>
+#include <io.h>
+#include <fcntl.h>
 #else
 #include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/statvfs.h>
+#include <sys/uio.h>
+#include <climits>
 #endif
 
 using namespace std;
@@ -36,65 +49,875 @@ int64_t FileUtils::getFileSize(const string& filename) {
     return rc == 0 ? stat_buf.st_size : -1;
 }
 
+int64_t FileUtils::getAvailableSpace(const string& path) {
+#ifdef _WIN32
+    ULARGE_INTEGER available;
+    if (!GetDiskFreeSpaceExA(path.c_str(), &available, NULL, NULL)) {
+        return -1;
+    }
+    return available.QuadPart;
+#else
+    struct statvfs info;
+    if (statvfs(path.c_str(), &info) != 0) {
+        return -1;
+    }
+    return static_cast<int64_t>(info.f_bavail) * info.f_frsize;
+#endif
+}
+
+MappedRegion::MappedRegion(const string& path, MapMode mode, uint64_t bytes, unsigned hints)
+    : path(path), mode(mode) {
+    bool create = mode == MapMode::SHARED && bytes > 0;
+#ifdef _WIN32
+    (void)hints;
+    if (create) {
+        ofstream created(path, ios::binary | ios::trunc);
+        if (!created) {
+            throw runtime_error("无法打开文件: " + path);
+        }
+        length = bytes;
+    } else {
+        int64_t fileSize = FileUtils::getFileSize(path);
+        if (fileSize < 0) {
+            throw runtime_error("无法打开文件: " + path);
+        }
+        length = fileSize;
+    }
+    fallback.resize(length);
+    if (!create && length > 0) {
+        ifstream inFile(path, ios::binary);
+        if (!inFile.read(fallback.data(), length)) {
+            throw runtime_error("读取文件失败: " + path);
+        }
+    }
+    base = length > 0 ? fallback.data() : nullptr;
+#else
+    int flags = mode == MapMode::SHARED ? O_RDWR : O_RDONLY;
+    int fd = open(path.c_str(), create ? flags | O_CREAT : flags, 0644);
+    if (fd < 0) {
+        throw runtime_error("无法打开文件: " + path);
+    }
+    if (create) {
+        if (ftruncate(fd, bytes) != 0) {
+            ::close(fd);
+            throw runtime_error("无法设置文件大小: " + path);
+        }
+        length = bytes;
+    } else {
+        struct stat info;
+        if (fstat(fd, &info) != 0) {
+            ::close(fd);
+            throw runtime_error("无法获取文件大小: " + path);
+        }
+        length = info.st_size;
+    }
+
+    // 空文件不建立映射
+    if (length > 0) {
+        int prot = mode == MapMode::READ_ONLY ? PROT_READ : PROT_READ | PROT_WRITE;
+        int mapFlags = mode == MapMode::SHARED ? MAP_SHARED : MAP_PRIVATE;
+#ifdef MAP_POPULATE
+        if (hints & MAP_HINT_POPULATE) mapFlags |= MAP_POPULATE;
+#endif
+        void* mapped = mmap(nullptr, length, prot, mapFlags, fd, 0);
+        if (mapped == MAP_FAILED) {
+            ::close(fd);
+            throw runtime_error(string("mmap 失败: ") + strerror(errno));
+        }
+        base = static_cast<char*>(mapped);
+#ifdef MADV_HUGEPAGE
+        if (hints & MAP_HINT_HUGE_PAGES) madvise(base, length, MADV_HUGEPAGE);
+#endif
+        if (hints & MAP_HINT_SEQUENTIAL) madvise(base, length, MADV_SEQUENTIAL);
+    }
+
+    // 映射建立后不再需要文件描述符
+    ::close(fd);
+#endif
+}
+
+MappedRegion::~MappedRegion() {
+    try {
+        close();
+    } catch (...) {
+    }
+}
+
+MappedRegion::MappedRegion(MappedRegion&& other) noexcept {
+    *this = move(other);
+}
+
+MappedRegion& MappedRegion::operator=(MappedRegion&& other) noexcept {
+    if (this != &other) {
+        try {
+            close();
+        } catch (...) {
+        }
+        path = move(other.path);
+        mode = other.mode;
+        base = other.base;
+        length = other.length;
+        fallback = move(other.fallback);
+        other.base = nullptr;
+        other.length = 0;
+    }
+    return *this;
+}
+
+void MappedRegion::sync() {
+    if (mode != MapMode::SHARED || base == nullptr) return;
+#ifdef _WIN32
+    ofstream outFile(path, ios::binary | ios::in | ios::out);
+    if (!outFile.write(fallback.data(), length)) {
+        throw runtime_error("写入文件失败: " + path);
+    }
+#else
+    if (msync(base, length, MS_SYNC) != 0) {
+        throw runtime_error(string("msync 失败: ") + strerror(errno));
+    }
+#endif
+}
+
+void MappedRegion::close() {
+    if (base == nullptr) return;
+#ifdef _WIN32
+    sync();
+    vector<char>().swap(fallback);
+#else
+    munmap(base, length);
+#endif
+    base = nullptr;
+    length = 0;
+}
+
+namespace {
+
+double secondsSince(chrono::steady_clock::time_point start) {
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+// 写出统计，可能由多个线程的输出文件同时记录
+mutex writeStatsMutex;
+uint64_t totalWriteBytes = 0;
+double totalWriteSeconds = 0;
+
+} // namespace
+
+// OutputFile 实现
+OutputFile::OutputFile(const string& path)
+    : path(path), opened(chrono::steady_clock::now()) {
+#ifdef _WIN32
+    fd = _open(path.c_str(), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, 0644);
+#else
+    fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+#endif
+    if (fd < 0) {
+        throw runtime_error("无法打开文件: " + path);
+    }
+}
+
+OutputFile::~OutputFile() {
+    if (fd >= 0) {
+#ifdef _WIN32
+        _close(fd);
+#else
+        ::close(fd);
+#endif
+    }
+}
+
+void OutputFile::writeAt(const void* data, size_t n, uint64_t offset) {
+    const char* src = static_cast<const char*>(data);
+    written += n;
+#ifdef _WIN32
+    // 没有 pwrite：定位后写入，只用于单线程
+    if (_lseeki64(fd, offset, SEEK_SET) < 0) {
+        throw runtime_error("写入文件失败: " + path);
+    }
+    while (n > 0) {
+        int w = _write(fd, src, static_cast<unsigned>(min<size_t>(n, 1 << 30)));
+        if (w < 0) {
+            throw runtime_error("写入文件失败: " + path);
+        }
+        src += w;
+        n -= w;
+    }
+#else
+    while (n > 0) {
+        ssize_t w = pwrite(fd, src, n, offset);
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            throw runtime_error("写入文件失败: " + path + ": " + strerror(errno));
+        }
+        src += w;
+        n -= w;
+        offset += w;
+    }
+#endif
+}
+
+void OutputFile::writevAt(const string_view* parts, size_t count, uint64_t offset) {
+#ifdef _WIN32
+    for (size_t i = 0; i < count; i++) {
+        writeAt(parts[i].data(), parts[i].size(), offset);
+        offset += parts[i].size();
+    }
+#else
+    // 每次最多 IOV_MAX 段；部分写入时从写到的位置继续
+    vector<iovec> iov;
+    iov.reserve(min<size_t>(count, IOV_MAX));
+    size_t next = 0;
+    while (next < count) {
+        iov.clear();
+        uint64_t batchBytes = 0;
+        for (; next < count && iov.size() < IOV_MAX; next++) {
+            if (parts[next].empty()) continue;
+            iov.push_back({const_cast<char*>(parts[next].data()), parts[next].size()});
+            batchBytes += parts[next].size();
+        }
+        written += batchBytes;
+        size_t first = 0;
+        while (first < iov.size()) {
+            ssize_t w = pwritev(fd, iov.data() + first, static_cast<int>(iov.size() - first), offset);
+            if (w < 0) {
+                if (errno == EINTR) continue;
+                throw runtime_error("写入文件失败: " + path + ": " + strerror(errno));
+            }
+            offset += w;
+            size_t remaining = w;
+            while (first < iov.size() && remaining >= iov[first].iov_len) {
+                remaining -= iov[first].iov_len;
+                first++;
+            }
+            if (first < iov.size()) {
+                iov[first].iov_base = static_cast<char*>(iov[first].iov_base) + remaining;
+                iov[first].iov_len -= remaining;
+            }
+        }
+    }
+#endif
+}
+
+void OutputFile::truncate(uint64_t size) {
+#ifdef _WIN32
+    int rc = _chsize_s(fd, size);
+#else
+    int rc = ftruncate(fd, size);
+#endif
+    if (rc != 0) {
+        throw runtime_error("无法设置文件大小: " + path);
+    }
+}
+
+void OutputFile::close() {
+    if (fd < 0) return;
+#ifdef _WIN32
+    int rc = _close(fd);
+#else
+    int rc = ::close(fd);
+#endif
+    fd = -1;
+    if (rc != 0) {
+        throw runtime_error("写入文件失败: " + path);
+    }
+    FileUtils::recordWrite(written, secondsSince(opened));
+}
+
+// BlockWriter 实现
+BlockWriter::BlockWriter(OutputFile& file, uint64_t startOffset, size_t blockSize)
+    : file(file), buffer(blockSize > 0 ? blockSize : FileUtils::getWriteBlockSize()),
+      used(0), offset(startOffset), written(0) {}
+
+void BlockWriter::write(const char* data, size_t n) {
+    if (used + n <= buffer.size()) {
+        memcpy(buffer.data() + used, data, n);
+        used += n;
+        if (used == buffer.size()) flush();
+        return;
+    }
+    if (n >= buffer.size()) {
+        // 大片段直接从调用者的内存写出
+        string_view parts[2] = {string_view(buffer.data(), used), string_view(data, n)};
+        file.writevAt(parts, 2, offset);
+        offset += used + n;
+        written += used + n;
+        used = 0;
+        return;
+    }
+    size_t room = buffer.size() - used;
+    memcpy(buffer.data() + used, data, room);
+    used += room;
+    flush();
+    memcpy(buffer.data(), data + room, n - room);
+    used = n - room;
+}
+
+void BlockWriter::flush() {
+    if (used == 0) return;
+    file.writeAt(buffer.data(), used, offset);
+    offset += used;
+    written += used;
+    used = 0;
+}
+
+uint64_t BlockWriter::finish() {
+    flush();
+    return written;
+}
+
+constexpr char DataFileHeader::MAGIC[8];
+
+uint8_t DataFileHeader::nativeEndianness() {
+    const uint16_t probe = 1;
+    return *reinterpret_cast<const uint8_t*>(&probe) == 1 ? LITTLE_ENDIAN_ORDER : BIG_ENDIAN_ORDER;
+}
+
+bool DataFileHeader::parse(const char* bytes, uint64_t fileSize, ElementType expected, DataFileHeader& header) {
+    if (fileSize < sizeof(DataFileHeader) || memcmp(bytes, MAGIC, sizeof(MAGIC)) != 0) {
+        return false;
+    }
+    DataFileHeader candidate;
+    memcpy(&candidate, bytes, sizeof(candidate));
+    uint64_t dataBytes = fileSize - sizeof(DataFileHeader);
+    if (candidate.version != VERSION || candidate.endianness != nativeEndianness() ||
+        (candidate.type != ElementType::INT64 && candidate.type != ElementType::DOUBLE) ||
+        dataBytes % 8 != 0 || candidate.count != dataBytes / 8) {
+        return false;
+    }
+    if (expected != ElementType::UNKNOWN && candidate.type != expected) {
+        throw runtime_error("数据文件的元素类型不符");
+    }
+    header = candidate;
+    return true;
+}
+
+namespace {
+
+// 元素位模式的混合函数（splitmix64 终结步骤），各元素的结果相加即为校验和
+uint64_t mixBits(uint64_t bits) {
+    bits ^= bits >> 30;
+    bits *= 0xbf58476d1ce4e5b9ULL;
+    bits ^= bits >> 27;
+    bits *= 0x94d049bb133111ebULL;
+    bits ^= bits >> 31;
+    return bits;
+}
+
 template<typename T>
-vector<T> FileUtils::readBinaryFile(const string& filename) {
-    ifstream inFile(filename, ios::binary | ios::ate);
-    if (!inFile) {
-        throw runtime_error("无法打开文件: " + filename);
+uint64_t toBits(const T& value) {
+    uint64_t bits = 0;
+    memcpy(&bits, &value, sizeof(T));
+    return bits;
+}
+
+} // namespace
+
+template<typename T>
+void DataHeaderBuilder<T>::add(const T* data, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        const T& value = data[i];
+        if (count == 0) {
+            minValue = maxValue = first = value;
+        } else {
+            if (value < last) ordered = false;
+            if (value < minValue) minValue = value;
+            if (maxValue < value) maxValue = value;
+        }
+        checksum += mixBits(toBits(value));
+        last = value;
+        count++;
     }
+}
 
-    streamsize fileSize = inFile.tellg();
-    inFile.seekg(0, ios::beg);
+template<typename T>
+void DataHeaderBuilder<T>::merge(const DataHeaderBuilder& next) {
+    if (next.count == 0) return;
+    if (count == 0) {
+        *this = next;
+        return;
+    }
+    if (!next.ordered || next.first < last) ordered = false;
+    if (next.minValue < minValue) minValue = next.minValue;
+    if (maxValue < next.maxValue) maxValue = next.maxValue;
+    last = next.last;
+    count += next.count;
+    checksum += next.checksum;
+}
+
+template<typename T>
+DataFileHeader DataHeaderBuilder<T>::header() const {
+    DataFileHeader header{};
+    memcpy(header.magic, DataFileHeader::MAGIC, sizeof(header.magic));
+    header.version = DataFileHeader::VERSION;
+    header.type = DataFileHeader::typeOf<T>();
+    header.endianness = DataFileHeader::nativeEndianness();
+    header.flags = ordered ? DATA_FLAG_SORTED : 0;
+    header.count = count;
+    header.minBits = count > 0 ? toBits(minValue) : 0;
+    header.maxBits = count > 0 ? toBits(maxValue) : 0;
+    header.checksum = checksum;
+    return header;
+}
+
+template<typename T>
+DataFileWriter<T>::DataFileWriter(const string& path, bool withHeader)
+    : file(path), writer(file, withHeader ? sizeof(DataFileHeader) : 0), withHeader(withHeader) {}
+
+template<typename T>
+void DataFileWriter<T>::write(const T* data, size_t count) {
+    if (withHeader) {
+        builder.add(data, count);
+    }
+    writer.write(reinterpret_cast<const char*>(data), count * sizeof(T));
+}
+
+template<typename T>
+void DataFileWriter<T>::finish() {
+    writer.finish();
+    if (withHeader) {
+        // 文件头的位置一开始就留出，最后回填
+        DataFileHeader header = builder.header();
+        file.writeAt(&header, sizeof(header), 0);
+    }
+    file.close();
+}
+
+namespace {
+
+// [begin, end) 中的行数：每个换行符结束一行，末尾没有换行的非空内容也算
+// 一行（与 getline 一致）
+size_t countLines(const char* begin, const char* end) {
+    size_t count = 0;
+    for (const char* p = begin; p < end; p++) {
+        p = static_cast<const char*>(memchr(p, '\n', end - p));
+        if (p == nullptr) return count + 1;
+        count++;
+    }
+    return count;
+}
+
+// 把 [begin, end) 中的各行依次写到 out
+void splitLines(const char* begin, const char* end, string_view* out) {
+    const char* p = begin;
+    while (p < end) {
+        const char* newline = static_cast<const char*>(memchr(p, '\n', end - p));
+        if (newline == nullptr) {
+            *out++ = string_view(p, end - p);
+            break;
+        }
+        *out++ = string_view(p, newline - p);
+        p = newline + 1;
+    }
+}
+
+} // namespace
+
+TextLines::TextLines(const string& path, unsigned threads)
+    : region(path, MapMode::READ_ONLY, 0, MAP_HINT_SEQUENTIAL) {
+    const char* data = region.data();
+    uint64_t length = region.size();
+    if (length == 0) return;
+
+    // 每个线程至少处理 4MB
+    const uint64_t MIN_CHUNK = 4 << 20;
+    if (threads == 0) {
+        threads = max(1u, thread::hardware_concurrency());
+    }
+    size_t chunks = max<uint64_t>(1, min<uint64_t>(threads, length / MIN_CHUNK));
+
+    // 块边界后移到下一行的行首
+    vector<const char*> bounds(chunks + 1);
+    bounds[0] = data;
+    bounds[chunks] = data + length;
+    for (size_t c = 1; c < chunks; c++) {
+        const char* guess = max(bounds[c - 1], data + length * c / chunks);
+        const char* newline = static_cast<const char*>(memchr(guess, '\n', data + length - guess));
+        bounds[c] = newline ? newline + 1 : data + length;
+    }
+
+    auto forEachChunk = [&](const function<void(size_t)>& work) {
+        vector<thread> workers;
+        for (size_t c = 1; c < chunks; c++) {
+            workers.emplace_back(work, c);
+        }
+        work(0);
+        for (auto& worker : workers) worker.join();
+    };
+
+    // 先数出各块的行数，再把各行直接写到最终位置（避免数组反复扩容）
+    vector<size_t> offsets(chunks + 1, 0);
+    forEachChunk([&](size_t c) {
+        offsets[c + 1] = countLines(bounds[c], bounds[c + 1]);
+    });
+    for (size_t c = 0; c < chunks; c++) {
+        offsets[c + 1] += offsets[c];
+    }
+    lines.resize(offsets[chunks]);
+    forEachChunk([&](size_t c) {
+        splitLines(bounds[c], bounds[c + 1], lines.data() + offsets[c]);
+    });
+}
+
+vector<string> TextLines::toStrings() const {
+    // 逐行分配是主要开销，分段并行复制
+    vector<string> result(lines.size());
+    const size_t MIN_LINES = 1 << 18;
+    size_t parts = max<size_t>(1, min<size_t>(max(1u, thread::hardware_concurrency()), lines.size() / MIN_LINES));
+
+    auto copyRange = [&](size_t part) {
+        size_t first = lines.size() * part / parts;
+        size_t last = lines.size() * (part + 1) / parts;
+        for (size_t i = first; i < last; i++) {
+            result[i].assign(lines[i].data(), lines[i].size());
+        }
+    };
+    vector<thread> workers;
+    for (size_t part = 1; part < parts; part++) {
+        workers.emplace_back(copyRange, part);
+    }
+    copyRange(0);
+    for (auto& worker : workers) worker.join();
+    return result;
+}
 
-    size_t elementCount = fileSize / sizeof(T);
-    vector<T> data(elementCount);
+constexpr char BinaryStrings::MAGIC[8];
+
+BinaryStrings::BinaryStrings(const string& path)
+    : region(path, MapMode::READ_ONLY, 0, MAP_HINT_SEQUENTIAL) {
+    BinaryStringHeader header;
+    if (region.size() < sizeof(header)) {
+        throw runtime_error("无效的二进制字符串文件: " + path);
+    }
+    memcpy(&header, region.data(), sizeof(header));
+    uint64_t tableBytes = (header.count + 1) * sizeof(uint64_t);
+    if (memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 ||
+        header.count > (region.size() - sizeof(header)) / sizeof(uint64_t) ||
+        region.size() != sizeof(header) + tableBytes + header.dataBytes) {
+        throw runtime_error("无效的二进制字符串文件: " + path);
+    }
 
-    inFile.read(reinterpret_cast<char*>(data.data()), fileSize);
-    inFile.close();
+    count = header.count;
+    offsets = reinterpret_cast<const uint64_t*>(region.data() + sizeof(header));
+    blob = region.data() + sizeof(header) + tableBytes;
+    if (offsets[0] != 0 || offsets[count] != header.dataBytes) {
+        throw runtime_error("二进制字符串文件偏移表损坏: " + path);
+    }
+}
 
+template<typename T>
+DataBuffer<T> FileUtils::readBinaryFile(const string& filename) {
+    int64_t fileSize = getFileSize(filename);
+    if (fileSize < 0) {
+        throw runtime_error("无法打开文件: " + filename);
+    }
+    DataFileHeader header;
+    uint64_t offset = readDataHeader(filename, header, DataFileHeader::typeOf<T>()) ? sizeof(DataFileHeader) : 0;
+    DataBuffer<T> data((fileSize - offset) / sizeof(T));
+    readParallel(filename, reinterpret_cast<char*>(data.data()), data.size() * sizeof(T), offset);
     return data;
 }
 
 template<typename T>
 void FileUtils::writeBinaryFile(const string& filename, const vector<T>& data) {
-    ofstream outFile(filename, ios::binary);
-    if (!outFile) {
-        throw runtime_error("无法打开文件: " + filename);
+    writeDataFile(filename, data.data(), data.size(), false);
+}
+
+template<typename T>
+void FileUtils::writeDataFile(const string& filename, const T* data, size_t count, bool withHeader) {
+    OutputFile file(filename);
+    uint64_t headerBytes = withHeader ? sizeof(DataFileHeader) : 0;
+    uint64_t bytes = static_cast<uint64_t>(count) * sizeof(T);
+    file.truncate(headerBytes + bytes);
+    if (withHeader) {
+        DataHeaderBuilder<T> builder;
+        builder.add(data, count);
+        DataFileHeader header = builder.header();
+        file.writeAt(&header, sizeof(header), 0);
     }
+    writeParallel(file, reinterpret_cast<const char*>(data), bytes, headerBytes);
+    file.close();
+}
 
-    outFile.write(reinterpret_cast<const char*>(data.data()),
-                 data.size() * sizeof(T));
-    outFile.close();
+namespace {
+
+// 并行读写时每个线程至少负责的字节数 / 行数
+const uint64_t MIN_IO_CHUNK = 4 << 20;
+const uint64_t MIN_WRITE_LINES = 1 << 18;
+
+// 并行读写区段边界的对齐粒度（页大小，也是常见设备的块大小）
+const uint64_t IO_ALIGNMENT = 4096;
+
+// amount 个单位的读写分给几个线程（每个线程至少 minPerThread 个单位）；
+// configured 为 FileUtils 中设置的线程数
+unsigned ioThreadCount(uint64_t amount, uint64_t minPerThread, unsigned configured) {
+#ifdef _WIN32
+    // 没有 pread/pwrite，只能单线程读写
+    (void)amount;
+    (void)minPerThread;
+    (void)configured;
+    return 1;
+#else
+    unsigned threads = configured > 0 ? configured : max(1u, thread::hardware_concurrency());
+    return static_cast<unsigned>(max<uint64_t>(1, min<uint64_t>(threads, amount / minPerThread)));
+#endif
 }
 
-vector<string> FileUtils::readTextFile(const string& filename) {
-    ifstream inFile(filename);
+// 文件中 [offset, offset + bytes) 分成 parts 段时第 part 段的起点（相对 offset），
+// 中间的边界落在对齐的文件偏移上
+uint64_t splitPoint(uint64_t offset, uint64_t bytes, unsigned part, unsigned parts) {
+    if (part == 0) return 0;
+    if (part >= parts) return bytes;
+    uint64_t boundary = (offset + bytes * part / parts) / IO_ALIGNMENT * IO_ALIGNMENT;
+    return boundary > offset ? boundary - offset : 0;
+}
+
+// 各段在各自的线程中执行（第 0 段在当前线程），任一段的异常在全部结束后重新抛出
+void runParts(unsigned parts, const function<void(unsigned)>& work) {
+    vector<exception_ptr> errors(parts);
+    auto guarded = [&](unsigned part) {
+        try {
+            work(part);
+        } catch (...) {
+            errors[part] = current_exception();
+        }
+    };
+    vector<thread> workers;
+    for (unsigned part = 1; part < parts; part++) {
+        workers.emplace_back(guarded, part);
+    }
+    guarded(0);
+    for (auto& worker : workers) worker.join();
+    for (auto& error : errors) {
+        if (error) rethrow_exception(error);
+    }
+}
+
+} // namespace
+
+void FileUtils::readParallel(const string& filename, char* dest, uint64_t bytes, uint64_t offset) {
+#ifdef _WIN32
+    ifstream inFile(filename, ios::binary);
     if (!inFile) {
         throw runtime_error("无法打开文件: " + filename);
     }
+    inFile.seekg(offset);
+    if (!inFile.read(dest, bytes)) {
+        throw runtime_error("读取文件失败: " + filename);
+    }
+#else
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw runtime_error("无法打开文件: " + filename);
+    }
+    unsigned parts = ioThreadCount(bytes, MIN_IO_CHUNK, getReadThreads());
+    try {
+        // 多个线程同时读，设备上同时有多个请求在排队
+        runParts(parts, [&](unsigned part) {
+            uint64_t pos = splitPoint(offset, bytes, part, parts);
+            uint64_t last = splitPoint(offset, bytes, part + 1, parts);
+            while (pos < last) {
+                ssize_t r = pread(fd, dest + pos, last - pos, offset + pos);
+                if (r < 0) {
+                    if (errno == EINTR) continue;
+                    throw runtime_error("读取文件失败: " + filename + ": " + strerror(errno));
+                }
+                if (r == 0) {
+                    throw runtime_error("文件被截断: " + filename);
+                }
+                pos += r;
+            }
+        });
+    } catch (...) {
+        ::close(fd);
+        throw;
+    }
+    ::close(fd);
+#endif
+}
+
+void FileUtils::writeParallel(OutputFile& file, const char* data, uint64_t bytes, uint64_t offset) {
+    unsigned parts = ioThreadCount(bytes, MIN_IO_CHUNK, getWriteThreads());
+    size_t block = getWriteBlockSize();
+    runParts(parts, [&](unsigned part) {
+        uint64_t first = splitPoint(offset, bytes, part, parts);
+        uint64_t last = splitPoint(offset, bytes, part + 1, parts);
+        for (uint64_t pos = first; pos < last; pos += block) {
+            file.writeAt(data + pos, min<uint64_t>(block, last - pos), offset + pos);
+        }
+    });
+}
+
+void FileUtils::writeLines(const string& filename, size_t count, const function<string_view(size_t)>& at) {
+    OutputFile file(filename);
+
+    unsigned parts = ioThreadCount(count, MIN_WRITE_LINES, getWriteThreads());
+    if (parts == 1) {
+        BlockWriter writer(file, 0);
+        for (size_t i = 0; i < count; i++) {
+            writer.writeLine(at(i));
+        }
+        writer.finish();
+        file.close();
+        return;
+    }
+
+    auto first = [&](unsigned part) { return count * part / parts; };
+    vector<uint64_t> offsets(parts + 1, 0);
+    runParts(parts, [&](unsigned part) {
+        uint64_t bytes = 0;
+        for (size_t i = first(part); i < first(part + 1); i++) {
+            bytes += at(i).size() + 1;
+        }
+        offsets[part + 1] = bytes;
+    });
+    for (unsigned part = 0; part < parts; part++) {
+        offsets[part + 1] += offsets[part];
+    }
+    file.truncate(offsets[parts]);
+    runParts(parts, [&](unsigned part) {
+        BlockWriter writer(file, offsets[part]);
+        for (size_t i = first(part); i < first(part + 1); i++) {
+            writer.writeLine(at(i));
+        }
+        writer.finish();
+    });
+    file.close();
+}
 
-    vector<string> lines;
-    string line;
+size_t FileUtils::writeBlockSize = 1 << 20;
+unsigned FileUtils::writeThreads = 0;
+unsigned FileUtils::readThreads = 0;
 
-    while (getline(inFile, line)) {
-        lines.push_back(line);
+void FileUtils::setWriteBlockSize(size_t bytes) {
+    if (bytes == 0) {
+        throw invalid_argument("输出块大小必须大于 0");
     }
+    writeBlockSize = bytes;
+}
 
-    inFile.close();
-    return lines;
+void FileUtils::resetWriteStats() {
+    lock_guard<mutex> lock(writeStatsMutex);
+    totalWriteBytes = 0;
+    totalWriteSeconds = 0;
 }
 
-void FileUtils::writeTextFile(const string& filename, const vector<string>& data) {
-    ofstream outFile(filename);
+void FileUtils::recordWrite(uint64_t bytes, double seconds) {
+    lock_guard<mutex> lock(writeStatsMutex);
+    totalWriteBytes += bytes;
+    totalWriteSeconds += seconds;
+}
+
+uint64_t FileUtils::getWriteBytes() {
+    lock_guard<mutex> lock(writeStatsMutex);
+    return totalWriteBytes;
+}
+
+double FileUtils::getWriteSeconds() {
+    lock_guard<mutex> lock(writeStatsMutex);
+    return totalWriteSeconds;
+}
+
+bool FileUtils::readDataHeader(const string& filename, DataFileHeader& header, ElementType expected) {
+    int64_t fileSize = getFileSize(filename);
+    if (fileSize < static_cast<int64_t>(sizeof(DataFileHeader))) {
+        return false;
+    }
+    char bytes[sizeof(DataFileHeader)];
+    ifstream inFile(filename, ios::binary);
+    if (!inFile.read(bytes, sizeof(bytes))) {
+        return false;
+    }
+    return DataFileHeader::parse(bytes, fileSize, expected, header);
+}
+
+uint64_t FileUtils::dataOffset(const string& filename) {
+    DataFileHeader header;
+    return readDataHeader(filename, header) ? sizeof(DataFileHeader) : 0;
+}
+
+void FileUtils::writeDataHeader(const string& filename, const DataFileHeader& header) {
+    fstream outFile(filename, ios::binary | ios::in | ios::out);
     if (!outFile) {
         throw runtime_error("无法打开文件: " + filename);
     }
+    outFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    outFile.close();
+    if (!outFile) {
+        throw runtime_error("写入文件失败: " + filename);
+    }
+}
+
+vector<string> FileUtils::readTextFile(const string& filename) {
+    return TextLines(filename).toStrings();
+}
+
+void FileUtils::writeTextFile(const string& filename, const vector<string>& data) {
+    writeLines(filename, data.size(), [&data](size_t i) { return string_view(data[i]); });
+}
+
+bool FileUtils::isBinaryStringFile(const string& filename) {
+    ifstream inFile(filename, ios::binary);
+    char magic[sizeof(BinaryStrings::MAGIC)];
+    return inFile.read(magic, sizeof(magic)) && memcmp(magic, BinaryStrings::MAGIC, sizeof(magic)) == 0;
+}
 
-    for (const auto& line : data) {
-        outFile << line << "\n";
+void FileUtils::writeBinaryStrings(const string& filename, size_t count,
+                                   const function<string_view(size_t)>& at) {
+    // 先由各字符串长度算出偏移表，文件头与偏移表因此可以先于数据写出，
+    // 数据区各段的位置也随之确定
+    vector<uint64_t> offsets(count + 1, 0);
+    for (size_t i = 0; i < count; i++) {
+        offsets[i + 1] = offsets[i] + at(i).size();
     }
 
-    outFile.close();
+    OutputFile file(filename);
+    BinaryStringHeader header;
+    memcpy(header.magic, BinaryStrings::MAGIC, sizeof(header.magic));
+    header.count = count;
+    header.dataBytes = offsets[count];
+    uint64_t dataStart = sizeof(header) + offsets.size() * sizeof(uint64_t);
+    file.truncate(dataStart + header.dataBytes);
+
+    string_view prefix[2] = {
+        string_view(reinterpret_cast<const char*>(&header), sizeof(header)),
+        string_view(reinterpret_cast<const char*>(offsets.data()), offsets.size() * sizeof(uint64_t))
+    };
+    file.writevAt(prefix, 2, 0);
+
+    unsigned parts = ioThreadCount(header.dataBytes, MIN_IO_CHUNK, getWriteThreads());
+    runParts(parts, [&](unsigned part) {
+        size_t first = count * part / parts;
+        size_t last = count * (part + 1) / parts;
+        BlockWriter writer(file, dataStart + offsets[first]);
+        for (size_t i = first; i < last; i++) {
+            string_view value = at(i);
+            writer.write(value.data(), value.size());
+        }
+        writer.finish();
+    });
+    file.close();
+}
+
+void FileUtils::textToBinaryStrings(const string& textFile, const string& binaryFile) {
+    TextLines lines(textFile);
+    writeBinaryStrings(binaryFile, lines.size(), [&lines](size_t i) { return lines[i]; });
+}
+
+void FileUtils::binaryToTextStrings(const string& binaryFile, const string& textFile) {
+    BinaryStrings strings(binaryFile);
+    writeLines(textFile, strings.size(), [&strings](size_t i) { return strings[i]; });
+}
+
+uint64_t FileUtils::countStrings(const string& filename) {
+    if (isBinaryStringFile(filename)) {
+        ifstream inFile(filename, ios::binary);
+        BinaryStringHeader header;
+        if (!inFile.read(reinterpret_cast<char*>(&header), sizeof(header))) {
+            throw runtime_error("无效的二进制字符串文件: " + filename);
+        }
+        return header.count;
+    }
+    return TextLines(filename).size();
 }
 
 bool FileUtils::cleanDirectory(const string& path) {
@@ -137,7 +960,13 @@ string FileUtils::getTempFilename(const string& prefix, int index) {
 }
 
 // 显式实例化模板
-template vector<int64_t> FileUtils::readBinaryFile<int64_t>(const string&);
-template vector<double> FileUtils::readBinaryFile<double>(const string&);
+template DataBuffer<int64_t> FileUtils::readBinaryFile<int64_t>(const string&);
+template DataBuffer<double> FileUtils::readBinaryFile<double>(const string&);
 template void FileUtils::writeBinaryFile<int64_t>(const string&, const vector<int64_t>&);
 template void FileUtils::writeBinaryFile<double>(const string&, const vector<double>&);
+template void FileUtils::writeDataFile<int64_t>(const string&, const int64_t*, size_t, bool);
+template void FileUtils::writeDataFile<double>(const string&, const double*, size_t, bool);
+template class DataHeaderBuilder<int64_t>;
+template class DataHeaderBuilder<double>;
+template class DataFileWriter<int64_t>;
+template class DataFileWriter<double>;
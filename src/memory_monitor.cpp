@@ -8,9 +8,11 @@
 
 #include <iostream>
 #include <sstream>
+#include <fstream>
 #include <iomanip>
 #include <vector>
 #include <algorithm>
+#include <cstdint>
 
 // 只在MSVC编译器中使用pragma指令
 #ifdef _MSC_VER
@@ -187,3 +189,74 @@ void MemoryMonitor::printMemoryInfo() {
 #endif
 }
 
+size_t MemoryMonitor::getAvailableSystemMemory() {
+#ifdef _WIN32
+    MEMORYSTATUSEX memStatus;
+    memStatus.dwLength = sizeof(memStatus);
+    if (GlobalMemoryStatusEx(&memStatus)) {
+        return memStatus.ullAvailPhys;
+    }
+    return 0;
+#else
+    ifstream meminfo("/proc/meminfo");
+    string key;
+    size_t value;
+    string unit;
+    while (meminfo >> key >> value) {
+        getline(meminfo, unit);
+        if (key == "MemAvailable:") {
+            return value * 1024; // kB
+        }
+    }
+    return 0;
+#endif
+}
+
+size_t MemoryMonitor::getCgroupMemoryHeadroom() {
+#ifdef _WIN32
+    return SIZE_MAX;
+#else
+    // cgroup v2: /proc/self/cgroup 中形如 "0::/path" 的一行
+    string cgroupPath;
+    ifstream cgroupFile("/proc/self/cgroup");
+    string line;
+    while (getline(cgroupFile, line)) {
+        if (line.compare(0, 3, "0::") == 0) {
+            cgroupPath = line.substr(3);
+            break;
+        }
+    }
+
+    vector<string> candidates;
+    if (!cgroupPath.empty() && cgroupPath != "/") {
+        candidates.push_back("/sys/fs/cgroup" + cgroupPath);
+    }
+    candidates.push_back("/sys/fs/cgroup");
+
+    for (const auto& dir : candidates) {
+        ifstream maxFile(dir + "/memory.max");
+        string limit;
+        if (!(maxFile >> limit)) continue;
+        if (limit == "max") return SIZE_MAX;
+
+        size_t current = 0;
+        ifstream currentFile(dir + "/memory.current");
+        currentFile >> current;
+
+        // memory.current 包含可回收的页缓存（如刚写出的顺串），不计入占用
+        ifstream statFile(dir + "/memory.stat");
+        string key;
+        size_t value;
+        while (statFile >> key >> value) {
+            if (key == "inactive_file") {
+                current = current > value ? current - value : 0;
+                break;
+            }
+        }
+
+        size_t maxBytes = stoull(limit);
+        return maxBytes > current ? maxBytes - current : 0;
+    }
+    return SIZE_MAX;
+#endif
+}
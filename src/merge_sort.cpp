@@ -9,8 +9,8 @@
 using namespace std;
 
 // 归并函数
-template<typename T, typename Compare>
-void MergeSort::merge(vector<T>& arr, int left, int mid, int right, Compare comp) {
+template<typename T, typename Alloc, typename Compare>
+void MergeSort::merge(vector<T, Alloc>& arr, int left, int mid, int right, Compare comp) {
     int n1 = mid - left + 1;
     int n2 = right - mid;
 
@@ -48,8 +48,8 @@ void MergeSort::merge(vector<T>& arr, int left, int mid, int right, Compare comp
 }
 
 // 递归归并排序
-template<typename T, typename Compare>
-void MergeSort::mergeSortRecursive(vector<T>& arr, int left, int right, Compare comp) {
+template<typename T, typename Alloc, typename Compare>
+void MergeSort::mergeSortRecursive(vector<T, Alloc>& arr, int left, int right, Compare comp) {
     if (left < right) {
         int mid = left + (right - left) / 2;
 
@@ -90,29 +90,40 @@ void MergeSort::sortInMemory(vector<double>& arr) {
     mergeSortRecursive(arr, 0, arr.size() - 1, less<double>());
 }
 
+// 文件数据缓冲区排序
+void MergeSort::sortInMemory(DataBuffer<int64_t>& arr) {
+    mergeSortRecursive(arr, 0, arr.size() - 1, less<int64_t>());
+}
+
+void MergeSort::sortInMemory(DataBuffer<double>& arr) {
+    mergeSortRecursive(arr, 0, arr.size() - 1, less<double>());
+}
+
 // 字符串排序
 void MergeSort::sortInMemory(vector<string>& arr) {
     mergeSortRecursive(arr, 0, arr.size() - 1, less<string>());
 }
 
+// 字符串列排序
+void MergeSort::sortInMemory(StringColumn& column) {
+    auto handles = column.makeHandles();
+    mergeSortRecursive(handles, 0, handles.size() - 1, column.handleLess());
+    column.permute(handles);
+}
+
 // 文件排序接口
 void MergeSort::sortIntegerFile(const string& inputFile, const string& outputFile) {
     try {
         // 读取数据
         auto data = DataGenerator::readIntegerData(inputFile);
 
-        // 排序
-        sortInMemory(data);
-
-        // 写入输出文件
-        ofstream outFile(outputFile, ios::binary);
-        if (!outFile) {
-            throw runtime_error("无法打开输出文件： " + outputFile);
+        // 排序（文件头已标记为有序时跳过）
+        if (!DataGenerator::isMarkedSorted(inputFile)) {
+            sortInMemory(data);
         }
 
-        outFile.write(reinterpret_cast<const char*>(data.data()),
-                     data.size() * sizeof(int64_t));
-        outFile.close();
+        // 写入输出文件（输入带文件头时输出也带）
+        DataGenerator::writeIntegerData(outputFile, data, DataGenerator::hasDataHeader(inputFile));
 
         cout << "整数文件排序完成： " << outputFile << endl;
     } catch (const exception& e) {
@@ -126,18 +137,13 @@ void MergeSort::sortDoubleFile(const string& inputFile, const string& outputFile
         // 读取数据
         auto data = DataGenerator::readDoubleData(inputFile);
 
-        // 排序
-        sortInMemory(data);
-
-        // 写入输出文件
-        ofstream outFile(outputFile, ios::binary);
-        if (!outFile) {
-            throw runtime_error("无法打开输出文件： " + outputFile);
+        // 排序（文件头已标记为有序时跳过）
+        if (!DataGenerator::isMarkedSorted(inputFile)) {
+            sortInMemory(data);
         }
 
-        outFile.write(reinterpret_cast<const char*>(data.data()),
-                     data.size() * sizeof(double));
-        outFile.close();
+        // 写入输出文件（输入带文件头时输出也带）
+        DataGenerator::writeDoubleData(outputFile, data, DataGenerator::hasDataHeader(inputFile));
 
         cout << "浮点数文件排序完成： " << outputFile << endl;
     } catch (const exception& e) {
@@ -148,22 +154,14 @@ void MergeSort::sortDoubleFile(const string& inputFile, const string& outputFile
 
 void MergeSort::sortStringFile(const string& inputFile, const string& outputFile) {
     try {
-        // 读取数据
-        auto data = DataGenerator::readStringData(inputFile);
+        // 读取数据（整列字节连续存放）
+        auto column = DataGenerator::readStringColumn(inputFile);
 
         // 排序
-        sortInMemory(data);
+        sortInMemory(column);
 
         // 写入输出文件
-        ofstream outFile(outputFile);
-        if (!outFile) {
-            throw runtime_error("无法打开输出文件： " + outputFile);
-        }
-
-        for (const auto& str : data) {
-            outFile << str << "\n";
-        }
-        outFile.close();
+        column.writeTextFile(outputFile);
 
         cout << "字符串文件排序完成： " << outputFile << endl;
     } catch (const exception& e) {
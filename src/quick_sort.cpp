@@ -25,27 +25,54 @@ int QuickSort::partition(vector<T>& arr, int low, int high, Compare comp) {
 }
 
 // 三路快速排序（处理重复元素）
-template<typename T, typename Compare>
-void QuickSort::threeWayQuickSort(vector<T>& arr, int low, int high, Compare comp) {
-    if (low >= high) return;
-
-    T pivot = arr[low];
-    int lt = low;      // arr[low..lt-1] < pivot
-    int gt = high;     // arr[gt+1..high] > pivot
-    int i = low + 1;   // arr[lt..i-1] == pivot
-
-    while (i <= gt) {
-        if (comp(arr[i], pivot)) {
-            swap(arr[lt++], arr[i++]);
-        } else if (comp(pivot, arr[i])) {
-            swap(arr[i], arr[gt--]);
-        } else {
-            i++;
+template<typename T, typename Alloc, typename Compare>
+void QuickSort::threeWayQuickSort(vector<T, Alloc>& arr, int low, int high, Compare comp, int depthLimit) {
+    if (depthLimit < 0) {
+        depthLimit = 0;
+        for (int n = high - low + 1; n > 1; n >>= 1) {
+            depthLimit += 2;
         }
     }
 
-    threeWayQuickSort(arr, low, lt - 1, comp);
-    threeWayQuickSort(arr, gt + 1, high, comp);
+    while (low < high) {
+        if (depthLimit-- == 0) {
+            // 划分持续失衡（对抗性输入）：剩余区间改用堆排序
+            make_heap(arr.begin() + low, arr.begin() + high + 1, comp);
+            sort_heap(arr.begin() + low, arr.begin() + high + 1, comp);
+            return;
+        }
+
+        // 首、中、尾三数取中作为基准，换到 low
+        int mid = low + (high - low) / 2;
+        if (comp(arr[mid], arr[low])) swap(arr[mid], arr[low]);
+        if (comp(arr[high], arr[low])) swap(arr[high], arr[low]);
+        if (comp(arr[high], arr[mid])) swap(arr[high], arr[mid]);
+        swap(arr[low], arr[mid]);
+
+        T pivot = arr[low];
+        int lt = low;      // arr[low..lt-1] < pivot
+        int gt = high;     // arr[gt+1..high] > pivot
+        int i = low + 1;   // arr[lt..i-1] == pivot
+
+        while (i <= gt) {
+            if (comp(arr[i], pivot)) {
+                swap(arr[lt++], arr[i++]);
+            } else if (comp(pivot, arr[i])) {
+                swap(arr[i], arr[gt--]);
+            } else {
+                i++;
+            }
+        }
+
+        // 只对较短的一侧递归，较长的一侧继续循环，栈深不超过 O(log n)
+        if (lt - low < high - gt) {
+            threeWayQuickSort(arr, low, lt - 1, comp, depthLimit);
+            low = gt + 1;
+        } else {
+            threeWayQuickSort(arr, gt + 1, high, comp, depthLimit);
+            high = lt - 1;
+        }
+    }
 }
 
 // 递归快速排序
@@ -106,29 +133,40 @@ void QuickSort::sortInMemory(vector<double>& arr) {
     threeWayQuickSort(arr, 0, arr.size() - 1, less<double>());
 }
 
+// 文件数据缓冲区排序
+void QuickSort::sortInMemory(DataBuffer<int64_t>& arr) {
+    threeWayQuickSort(arr, 0, arr.size() - 1, less<int64_t>());
+}
+
+void QuickSort::sortInMemory(DataBuffer<double>& arr) {
+    threeWayQuickSort(arr, 0, arr.size() - 1, less<double>());
+}
+
 // 字符串排序
 void QuickSort::sortInMemory(vector<string>& arr) {
     threeWayQuickSort(arr, 0, arr.size() - 1, less<string>());
 }
 
+// 字符串列排序
+void QuickSort::sortInMemory(StringColumn& column) {
+    auto handles = column.makeHandles();
+    threeWayQuickSort(handles, 0, handles.size() - 1, column.handleLess());
+    column.permute(handles);
+}
+
 // 文件排序接口
 void QuickSort::sortIntegerFile(const string& inputFile, const string& outputFile) {
     try {
         // 读取数据
         auto data = DataGenerator::readIntegerData(inputFile);
 
-        // 排序
-        sortInMemory(data);
-
-        // 写入输出文件
-        ofstream outFile(outputFile, ios::binary);
-        if (!outFile) {
-            throw runtime_error("无法打开输出文件：" + outputFile);
+        // 排序（文件头已标记为有序时跳过）
+        if (!DataGenerator::isMarkedSorted(inputFile)) {
+            sortInMemory(data);
         }
 
-        outFile.write(reinterpret_cast<const char*>(data.data()),
-                     data.size() * sizeof(int64_t));
-        outFile.close();
+        // 写入输出文件（输入带文件头时输出也带）
+        DataGenerator::writeIntegerData(outputFile, data, DataGenerator::hasDataHeader(inputFile));
 
         cout << "整数文件排序完成：" << outputFile << endl;
     } catch (const exception& e) {
@@ -142,18 +180,13 @@ void QuickSort::sortDoubleFile(const string& inputFile, const string& outputFile
         // 读取数据
         auto data = DataGenerator::readDoubleData(inputFile);
 
-        // 排序
-        sortInMemory(data);
-
-        // 写入输出文件
-        ofstream outFile(outputFile, ios::binary);
-        if (!outFile) {
-            throw runtime_error("无法打开输出文件：" + outputFile);
+        // 排序（文件头已标记为有序时跳过）
+        if (!DataGenerator::isMarkedSorted(inputFile)) {
+            sortInMemory(data);
         }
 
-        outFile.write(reinterpret_cast<const char*>(data.data()),
-                     data.size() * sizeof(double));
-        outFile.close();
+        // 写入输出文件（输入带文件头时输出也带）
+        DataGenerator::writeDoubleData(outputFile, data, DataGenerator::hasDataHeader(inputFile));
 
         cout << "浮点数文件排序完成：" << outputFile << endl;
     } catch (const exception& e) {
@@ -164,22 +197,14 @@ void QuickSort::sortDoubleFile(const string& inputFile, const string& outputFile
 
 void QuickSort::sortStringFile(const string& inputFile, const string& outputFile) {
     try {
-        // 读取数据
-        auto data = DataGenerator::readStringData(inputFile);
+        // 读取数据（整列字节连续存放）
+        auto column = DataGenerator::readStringColumn(inputFile);
 
         // 排序
-        sortInMemory(data);
+        sortInMemory(column);
 
         // 写入输出文件
-        ofstream outFile(outputFile);
-        if (!outFile) {
-            throw runtime_error("无法打开输出文件：" + outputFile);
-        }
-
-        for (const auto& str : data) {
-            outFile << str << "\n";
-        }
-        outFile.close();
+        column.writeTextFile(outputFile);
 
         cout << "字符串文件排序完成：" << outputFile << endl;
     } catch (const exception& e) {
@@ -52,6 +52,24 @@ void RadixSort::countingSort(vector<int64_t>& arr, int exp) {
     }
 }
 
+// 句柄的计数排序（稳定）
+void RadixSort::countingSort(vector<StringColumn::Handle>& handles, int byte) {
+    vector<StringColumn::Handle> output(handles.size());
+    vector<size_t> count(257, 0);
+    int shift = 56 - 8 * byte;
+
+    for (const auto& handle : handles) {
+        count[((handle.prefix >> shift) & 0xFF) + 1]++;
+    }
+    for (int i = 1; i < 257; i++) {
+        count[i] += count[i - 1];
+    }
+    for (const auto& handle : handles) {
+        output[count[(handle.prefix >> shift) & 0xFF]++] = handle;
+    }
+    handles.swap(output);
+}
+
 // 字符串基数排序的计数排序
 void RadixSort::countingSort(vector<string>& arr, int pos) {
     int n = arr.size();
@@ -82,8 +100,9 @@ void RadixSort::countingSort(vector<string>& arr, int pos) {
     }
 }
 
-// 整数排序（只支持非负整数）
-void RadixSort::sortInMemory(vector<int64_t>& arr) {
+// 整数基数排序
+template<typename Alloc>
+void RadixSort::sortIntegers(vector<int64_t, Alloc>& arr) {
     // 先找出负数，单独处理
     vector<int64_t> negatives;
     vector<int64_t> nonNegatives;
@@ -126,6 +145,16 @@ void RadixSort::sortInMemory(vector<int64_t>& arr) {
     arr.insert(arr.end(), nonNegatives.begin(), nonNegatives.end());
 }
 
+// 整数排序（只支持非负整数）
+void RadixSort::sortInMemory(vector<int64_t>& arr) {
+    sortIntegers(arr);
+}
+
+// 文件数据缓冲区排序
+void RadixSort::sortInMemory(DataBuffer<int64_t>& arr) {
+    sortIntegers(arr);
+}
+
 // 字符串排序
 void RadixSort::sortInMemory(vector<string>& arr) {
     if (arr.empty()) return;
@@ -144,24 +173,82 @@ void RadixSort::sortInMemory(vector<string>& arr) {
     }
 }
 
+// 字符串列排序：对 8 字节键前缀做 LSD 基数排序，前缀相同的组再按后续字节块继续基数排序
+void RadixSort::sortInMemory(StringColumn& column) {
+    auto handles = column.makeHandles();
+    sortByPrefix(handles);
+    sortTieGroups(column, handles, 8);
+    column.permute(handles);
+}
+
+// 按句柄的 prefix 做 LSD 基数排序，所有句柄共有的字节不必排序
+void RadixSort::sortByPrefix(vector<StringColumn::Handle>& handles) {
+    if (handles.empty()) return;
+    uint64_t differing = 0;
+    for (const auto& handle : handles) {
+        differing |= handle.prefix ^ handles[0].prefix;
+    }
+    for (int byte = 7; byte >= 0; byte--) {
+        if ((differing >> (56 - 8 * byte)) & 0xFF) {
+            countingSort(handles, byte);
+        }
+    }
+}
+
+// 已按前 depth 字节排好的句柄中，prefix 相同的组以第 depth 字节起的 8 字节块为键
+// 再排序（MSD），块仍相同的子组继续向后；小组和已越过组内所有字符串末尾的组直接比较
+void RadixSort::sortTieGroups(const StringColumn& column, vector<StringColumn::Handle>& handles, size_t depth) {
+    const size_t SMALL_GROUP = 32;
+
+    // 组内字符串的前 depth 字节（不足补零）相同，只需比较其后的部分
+    auto tailLess = [&column, depth](const StringColumn::Handle& a, const StringColumn::Handle& b) {
+        string_view left = column[a.index];
+        string_view right = column[b.index];
+        size_t skip = min({depth, left.size(), right.size()});
+        return left.substr(skip) < right.substr(skip);
+    };
+
+    size_t groupStart = 0;
+    for (size_t i = 1; i <= handles.size(); i++) {
+        if (i < handles.size() && handles[i].prefix == handles[groupStart].prefix) continue;
+
+        size_t n = i - groupStart;
+        if (n > 1) {
+            auto first = handles.begin() + groupStart;
+            uint32_t maxLength = 0;
+            for (auto it = first; it != first + n; ++it) {
+                maxLength = max(maxLength, it->length);
+            }
+            if (n < SMALL_GROUP || depth >= maxLength) {
+                sort(first, first + n, tailLess);
+            } else {
+                vector<StringColumn::Handle> group(first, first + n);
+                for (auto& handle : group) {
+                    string_view value = column[handle.index];
+                    handle.prefix = StringColumn::keyPrefix(value.substr(min<size_t>(depth, value.size())));
+                }
+                sortByPrefix(group);
+                sortTieGroups(column, group, depth + 8);
+                copy(group.begin(), group.end(), first);
+            }
+        }
+        groupStart = i;
+    }
+}
+
 // 文件排序接口
 void RadixSort::sortIntegerFile(const string& inputFile, const string& outputFile) {
     try {
         // 读取数据
         auto data = DataGenerator::readIntegerData(inputFile);
 
-        // 排序
-        sortInMemory(data);
-
-        // 写入输出文件
-        ofstream outFile(outputFile, ios::binary);
-        if (!outFile) {
-            throw runtime_error("无法打开输出文件: " + outputFile);
+        // 排序（文件头已标记为有序时跳过）
+        if (!DataGenerator::isMarkedSorted(inputFile)) {
+            sortInMemory(data);
         }
 
-        outFile.write(reinterpret_cast<const char*>(data.data()),
-                     data.size() * sizeof(int64_t));
-        outFile.close();
+        // 写入输出文件（输入带文件头时输出也带）
+        DataGenerator::writeIntegerData(outputFile, data, DataGenerator::hasDataHeader(inputFile));
 
         cout << "整数文件排序完成: " << outputFile << endl;
     } catch (const exception& e) {
@@ -172,22 +259,14 @@ void RadixSort::sortIntegerFile(const string& inputFile, const string& outputFil
 
 void RadixSort::sortStringFile(const string& inputFile, const string& outputFile) {
     try {
-        // 读取数据
-        auto data = DataGenerator::readStringData(inputFile);
+        // 读取数据（整列字节连续存放）
+        auto column = DataGenerator::readStringColumn(inputFile);
 
         // 排序
-        sortInMemory(data);
+        sortInMemory(column);
 
         // 写入输出文件
-        ofstream outFile(outputFile);
-        if (!outFile) {
-            throw runtime_error("无法打开输出文件: " + outputFile);
-        }
-
-        for (const auto& str : data) {
-            outFile << str << "\n";
-        }
-        outFile.close();
+        column.writeTextFile(outputFile);
 
         cout << "字符串文件排序完成: " << outputFile << endl;
     } catch (const exception& e) {
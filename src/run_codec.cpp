@@ -0,0 +1,88 @@
+#include "run_codec.h"
+#include <cstring>
+#include <stdexcept>
+
+using namespace std;
+
+void RunCodec::encodeBlock(const uint64_t* keys, size_t count, vector<char>& out) {
+    size_t headerPos = out.size();
+    out.resize(headerPos + HEADER_BYTES);
+
+    // 差分使用无符号回绕减法，即使输入不是严格递增也能无损还原
+    for (size_t i = 1; i < count; i++) {
+        uint64_t delta = keys[i] - keys[i - 1];
+        while (delta >= 0x80) {
+            out.push_back(static_cast<char>((delta & 0x7F) | 0x80));
+            delta >>= 7;
+        }
+        out.push_back(static_cast<char>(delta));
+    }
+
+    BlockHeader header;
+    header.count = static_cast<uint32_t>(count);
+    header.payloadBytes = static_cast<uint32_t>(out.size() - headerPos - HEADER_BYTES);
+    header.firstKey = count > 0 ? keys[0] : 0;
+
+    char* dst = out.data() + headerPos;
+    memcpy(dst, &header.count, 4);
+    memcpy(dst + 4, &header.payloadBytes, 4);
+    memcpy(dst + 8, &header.firstKey, 8);
+}
+
+RunCodec::BlockHeader RunCodec::readHeader(const char* block) {
+    BlockHeader header;
+    memcpy(&header.count, block, 4);
+    memcpy(&header.payloadBytes, block + 4, 4);
+    memcpy(&header.firstKey, block + 8, 8);
+    return header;
+}
+
+const char* RunCodec::decodeBlock(const char* block, uint64_t* keys) {
+    BlockHeader header = readHeader(block);
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(block + HEADER_BYTES);
+    const unsigned char* end = p + header.payloadBytes;
+
+    if (header.count == 0) {
+        return reinterpret_cast<const char*>(end);
+    }
+
+    uint64_t key = header.firstKey;
+    keys[0] = key;
+    for (uint32_t i = 1; i < header.count; i++) {
+        uint64_t delta = 0;
+        int shift = 0;
+        while (true) {
+            if (p >= end) {
+                throw runtime_error("损坏的顺串编码块");
+            }
+            unsigned char byte = *p++;
+            delta |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) break;
+            shift += 7;
+        }
+        key += delta;
+        keys[i] = key;
+    }
+
+    return reinterpret_cast<const char*>(end);
+}
+
+uint64_t RunCodec::toKey(int64_t value) {
+    return static_cast<uint64_t>(value) ^ (1ULL << 63);
+}
+
+uint64_t RunCodec::toKey(double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    // 负数取反，非负数置符号位，使无符号比较与数值顺序一致
+    return (bits & (1ULL << 63)) ? ~bits : (bits | (1ULL << 63));
+}
+
+void RunCodec::fromKey(uint64_t key, int64_t& value) {
+    value = static_cast<int64_t>(key ^ (1ULL << 63));
+}
+
+void RunCodec::fromKey(uint64_t key, double& value) {
+    uint64_t bits = (key & (1ULL << 63)) ? (key & ~(1ULL << 63)) : ~key;
+    memcpy(&value, &bits, sizeof(value));
+}
@@ -1,5 +1,6 @@
 #include "shell_sort.h"
 #include "data_generator.h"
+#include "file_utils.h"
 #include <fstream>
 #include <iostream>
 #include <algorithm>
@@ -55,24 +56,24 @@ void ShellSort::sortInMemory(vector<string>& arr) {
     shellSortImpl(arr.data(), arr.size(), less<string>());
 }
 
+// 字符串列排序
+void ShellSort::sortInMemory(StringColumn& column) {
+    auto handles = column.makeHandles();
+    shellSortImpl(handles.data(), handles.size(), column.handleLess());
+    column.permute(handles);
+}
+
 // 文件排序接口
 void ShellSort::sortIntegerFile(const string& inputFile, const string& outputFile) {
     try {
-        // 读取数据
-        auto data = DataGenerator::readIntegerData(inputFile);
-
-        // 排序
-        sortInMemory(data);
-
-        // 写入输出文件
-        ofstream outFile(outputFile, ios::binary);
-        if (!outFile) {
-            throw runtime_error("无法打开输出文件：" + outputFile);
+        // 写时复制映射输入，直接在映射上原地排序
+        auto data = DataGenerator::mapIntegerData(inputFile, MapMode::PRIVATE);
+        if (!(data.hasHeader() && data.header().sorted())) {
+            shellSortImpl(data.data(), data.size(), less<int64_t>());
         }
 
-        outFile.write(reinterpret_cast<const char*>(data.data()),
-                     data.size() * sizeof(int64_t));
-        outFile.close();
+        // 按块并行写出（输入带文件头时输出也带）
+        FileUtils::writeDataFile(outputFile, data.data(), data.size(), data.hasHeader());
 
         cout << "整数文件排序完成：" << outputFile << endl;
     } catch (const exception& e) {
@@ -83,21 +84,14 @@ void ShellSort::sortIntegerFile(const string& inputFile, const string& outputFil
 
 void ShellSort::sortDoubleFile(const string& inputFile, const string& outputFile) {
     try {
-        // 读取数据
-        auto data = DataGenerator::readDoubleData(inputFile);
-
-        // 排序
-        sortInMemory(data);
-
-        // 写入输出文件
-        ofstream outFile(outputFile, ios::binary);
-        if (!outFile) {
-            throw runtime_error("无法打开输出文件：" + outputFile);
+        // 写时复制映射输入，直接在映射上原地排序
+        auto data = DataGenerator::mapDoubleData(inputFile, MapMode::PRIVATE);
+        if (!(data.hasHeader() && data.header().sorted())) {
+            shellSortImpl(data.data(), data.size(), less<double>());
         }
 
-        outFile.write(reinterpret_cast<const char*>(data.data()),
-                     data.size() * sizeof(double));
-        outFile.close();
+        // 按块并行写出（输入带文件头时输出也带）
+        FileUtils::writeDataFile(outputFile, data.data(), data.size(), data.hasHeader());
 
         cout << "浮点数文件排序完成：" << outputFile << endl;
     } catch (const exception& e) {
@@ -108,22 +102,14 @@ void ShellSort::sortDoubleFile(const string& inputFile, const string& outputFile
 
 void ShellSort::sortStringFile(const string& inputFile, const string& outputFile) {
     try {
-        // 读取数据
-        auto data = DataGenerator::readStringData(inputFile);
+        // 读取数据（整列字节连续存放）
+        auto column = DataGenerator::readStringColumn(inputFile);
 
         // 排序
-        sortInMemory(data);
+        sortInMemory(column);
 
         // 写入输出文件
-        ofstream outFile(outputFile);
-        if (!outFile) {
-            throw runtime_error("无法打开输出文件：" + outputFile);
-        }
-
-        for (const auto& str : data) {
-            outFile << str << "\n";
-        }
-        outFile.close();
+        column.writeTextFile(outputFile);
 
         cout << "字符串文件排序完成：" << outputFile << endl;
     } catch (const exception& e) {
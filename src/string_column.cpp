@@ -0,0 +1,114 @@
+#include "string_column.h"
+#include "file_utils.h"
+#include <fstream>
+#include <stdexcept>
+#include <climits>
+
+using namespace std;
+
+StringColumn StringColumn::fromTextFile(const string& path) {
+    TextLines lines(path);
+    StringColumn column;
+    if (lines.size() == 0) return column;
+
+    // 各行在映射中本就连续（以换行分隔），整段复制后把视图换算成偏移
+    const char* base = lines[0].data();
+    string_view last = lines[lines.size() - 1];
+    column.arena.assign(base, last.data() + last.size());
+    column.offsets.resize(lines.size());
+    column.lengths.resize(lines.size());
+    for (size_t i = 0; i < lines.size(); i++) {
+        if (lines[i].size() > UINT32_MAX) {
+            throw runtime_error("字符串过长: " + path);
+        }
+        column.offsets[i] = lines[i].data() - base;
+        column.lengths[i] = static_cast<uint32_t>(lines[i].size());
+    }
+    return column;
+}
+
+StringColumn StringColumn::fromBinaryFile(const string& path) {
+    BinaryStrings strings(path);
+    StringColumn column;
+    column.arena.assign(strings.data(), strings.data() + strings.dataBytes());
+    column.offsets.resize(strings.size());
+    column.lengths.resize(strings.size());
+    for (size_t i = 0; i < strings.size(); i++) {
+        uint64_t length = strings.offset(i + 1) - strings.offset(i);
+        if (length > UINT32_MAX) {
+            throw runtime_error("字符串过长: " + path);
+        }
+        column.offsets[i] = strings.offset(i);
+        column.lengths[i] = static_cast<uint32_t>(length);
+    }
+    return column;
+}
+
+void StringColumn::reserve(size_t count, size_t bytes) {
+    arena.reserve(bytes);
+    offsets.reserve(count);
+    lengths.reserve(count);
+}
+
+void StringColumn::push_back(string_view value) {
+    if (value.size() > UINT32_MAX) {
+        throw runtime_error("字符串过长");
+    }
+    offsets.push_back(arena.size());
+    lengths.push_back(static_cast<uint32_t>(value.size()));
+    arena.insert(arena.end(), value.begin(), value.end());
+}
+
+void StringColumn::clear() {
+    arena.clear();
+    offsets.clear();
+    lengths.clear();
+}
+
+size_t StringColumn::memoryBytes() const {
+    return arena.capacity() + offsets.capacity() * sizeof(uint64_t) + lengths.capacity() * sizeof(uint32_t);
+}
+
+uint64_t StringColumn::keyPrefix(string_view value) {
+    uint64_t prefix = 0;
+    size_t n = min<size_t>(8, value.size());
+    for (size_t i = 0; i < n; i++) {
+        prefix |= static_cast<uint64_t>(static_cast<unsigned char>(value[i])) << (56 - 8 * i);
+    }
+    return prefix;
+}
+
+vector<StringColumn::Handle> StringColumn::makeHandles() const {
+    if (size() > UINT32_MAX) {
+        throw runtime_error("字符串数量超过句柄下标范围");
+    }
+    vector<Handle> handles(size());
+    for (size_t i = 0; i < size(); i++) {
+        handles[i] = Handle{keyPrefix((*this)[i]), static_cast<uint32_t>(i), lengths[i]};
+    }
+    return handles;
+}
+
+void StringColumn::permute(const vector<Handle>& order) {
+    vector<char> sortedArena;
+    sortedArena.reserve(arena.size());
+    vector<uint64_t> sortedOffsets(order.size());
+    vector<uint32_t> sortedLengths(order.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        string_view value = (*this)[order[i].index];
+        sortedOffsets[i] = sortedArena.size();
+        sortedLengths[i] = order[i].length;
+        sortedArena.insert(sortedArena.end(), value.begin(), value.end());
+    }
+    arena.swap(sortedArena);
+    offsets.swap(sortedOffsets);
+    lengths.swap(sortedLengths);
+}
+
+void StringColumn::writeTextFile(const string& path) const {
+    FileUtils::writeLines(path, size(), [this](size_t i) { return (*this)[i]; });
+}
+
+void StringColumn::writeTextFile(const string& path, const vector<Handle>& order) const {
+    FileUtils::writeLines(path, order.size(), [this, &order](size_t i) { return (*this)[order[i].index]; });
+}